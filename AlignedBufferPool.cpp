@@ -0,0 +1,156 @@
+#include <cerrno>
+#include <cstdlib>
+#include <utility>
+#include "AlignedBufferPool.h"
+#include "PosixError.h"
+
+using namespace posixcpp;
+
+AlignedBuffer::AlignedBuffer() noexcept
+: m_pool(nullptr),
+  m_data(nullptr),
+  m_size(0),
+  m_capacity(0)
+{
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBufferPool* pool, char* data, size_t capacity) noexcept
+: m_pool(pool),
+  m_data(data),
+  m_size(capacity),
+  m_capacity(capacity)
+{
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+: m_pool(other.m_pool),
+  m_data(other.m_data),
+  m_size(other.m_size),
+  m_capacity(other.m_capacity)
+{
+    other.m_pool = nullptr;
+    other.m_data = nullptr;
+    other.m_size = other.m_capacity = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        std::swap(m_pool,other.m_pool);
+        std::swap(m_data,other.m_data);
+        std::swap(m_size,other.m_size);
+        std::swap(m_capacity,other.m_capacity);
+    }
+    return *this;
+}
+
+AlignedBuffer::~AlignedBuffer()
+{
+    release();
+}
+
+void AlignedBuffer::release() noexcept
+{
+    if (m_data)
+    {
+        m_pool->giveBack(m_data);
+    }
+    m_pool = nullptr;
+    m_data = nullptr;
+    m_size = m_capacity = 0;
+}
+
+void AlignedBuffer::resize(size_t size)
+{
+    if (size > m_capacity)
+    {
+        throw PosixError("AlignedBuffer::resize beyond capacity",EINVAL);
+    }
+    m_size = size;
+}
+
+AlignedBufferPool::AlignedBufferPool(size_t bufferSize, size_t count, size_t alignment)
+: m_alignment(alignment),
+  m_allocated(0)
+{
+    if (alignment == 0 or (alignment & (alignment-1)) != 0 or alignment % sizeof(void*) != 0)
+    {
+        throw PosixError("AlignedBufferPool alignment must be a power of two",EINVAL);
+    }
+    m_bufferSize = (bufferSize+alignment-1) & ~(alignment-1);
+    m_free.reserve(count);
+    try
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            m_free.push_back(allocate());
+        }
+    }
+    catch (...)
+    {
+        for (char* data : m_free)
+        {
+            ::free(data);
+        }
+        throw;
+    }
+}
+
+AlignedBufferPool::~AlignedBufferPool()
+{
+    for (char* data : m_free)
+    {
+        ::free(data);
+    }
+}
+
+char* AlignedBufferPool::allocate()
+{
+    void* data = nullptr;
+    // posix_memalign returns the error rather than setting errno
+    int r = ::posix_memalign(&data,m_alignment,m_bufferSize);
+    if (r != 0)
+    {
+        throw PosixError("posix_memalign",r);
+    }
+    m_allocated++;
+    return static_cast<char*>(data);
+}
+
+AlignedBuffer AlignedBufferPool::acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    char* data;
+    if (m_free.empty())
+    {
+        // Room for it to come back first, so giveBack() cannot fail
+        m_free.reserve(m_allocated+1);
+        data = allocate();
+    }
+    else
+    {
+        data = m_free.back();
+        m_free.pop_back();
+    }
+    return AlignedBuffer(this,data,m_bufferSize);
+}
+
+void AlignedBufferPool::giveBack(char* data) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(data);
+}
+
+size_t AlignedBufferPool::allocated()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocated;
+}
+
+size_t AlignedBufferPool::available()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
@@ -0,0 +1,113 @@
+#ifndef ALIGNEDBUFFERPOOL_H
+#define ALIGNEDBUFFERPOOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace posixcpp
+{
+
+class AlignedBufferPool;
+
+/*
+** A buffer on loan from an AlignedBufferPool, returned to it on destruction.
+** It has value_type, size(), resize() and operator[], so it can be used with
+** the File::read<Typ>() and write<Typ>() templates. resize() only changes the
+** length in use, up to capacity(), and never allocates.
+*/
+class AlignedBuffer
+{
+protected:
+    AlignedBufferPool* m_pool;
+    char* m_data;
+    size_t m_size;
+    size_t m_capacity;
+
+    friend class AlignedBufferPool;
+    AlignedBuffer(AlignedBufferPool* pool, char* data, size_t capacity) noexcept;
+
+public:
+    typedef char value_type;
+
+    AlignedBuffer() noexcept;
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept;
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+    ~AlignedBuffer();
+
+    /// Give the buffer back to the pool now. The object is left empty
+    void release() noexcept;
+
+    char* data() {return m_data;};
+    const char* data() const {return m_data;};
+
+    size_t size() const {return m_size;};
+
+    size_t capacity() const {return m_capacity;};
+
+    /// Set the length in use. Throws PosixError(EINVAL) beyond capacity()
+    void resize(size_t size);
+
+    char& operator[](size_t i) {return m_data[i];};
+    const char& operator[](size_t i) const {return m_data[i];};
+
+    char* begin() {return m_data;};
+    char* end() {return m_data+m_size;};
+
+    explicit operator bool() const {return m_data != nullptr;};
+};
+
+/*
+** Reusable buffers for direct I/O, aligned to a page (or any power of two)
+** and of a fixed size rounded up to a multiple of the alignment. Buffers are
+** allocated in the constructor, or by acquire() when none are free, and kept
+** for reuse until the pool is destroyed, so steady state I/O allocates
+** nothing. acquire() is thread safe. The pool must outlive its buffers.
+*/
+class AlignedBufferPool
+{
+protected:
+    size_t m_bufferSize;
+    size_t m_alignment;
+    std::mutex m_mutex;
+    std::vector<char*> m_free;
+    size_t m_allocated;
+
+    friend class AlignedBuffer;
+    void giveBack(char* data) noexcept;
+
+    char* allocate();
+
+public:
+    static const size_t DEFAULT_ALIGNMENT = 4096;
+
+    /// Preallocate count buffers of at least bufferSize bytes
+    AlignedBufferPool(size_t bufferSize, size_t count=0, size_t alignment=DEFAULT_ALIGNMENT);
+
+    AlignedBufferPool(const AlignedBufferPool&) = delete;
+    AlignedBufferPool& operator=(const AlignedBufferPool&) = delete;
+
+    ~AlignedBufferPool();
+
+    /// A free buffer, of size bufferSize(). Allocates only if none is free
+    AlignedBuffer acquire();
+
+    size_t bufferSize() const {return m_bufferSize;};
+
+    size_t alignment() const {return m_alignment;};
+
+    /// Buffers allocated over the life of the pool
+    size_t allocated();
+
+    /// Buffers ready to be acquired
+    size_t available();
+};
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include <cstring>
+#include <exception>
+#include "PosixError.h"
+#include "BufferedFile.h"
+
+using namespace posixcpp;
+
+BufferedFile::BufferedFile(File& file, size_t bufferSize)
+: m_file(file),
+  m_buf(bufferSize),
+  m_begin(0),
+  m_end(0),
+  m_mode(IDLE)
+{
+    if (bufferSize == 0)
+    {
+        throw PosixError("BufferedFile needs a non-empty buffer",EINVAL);
+    }
+}
+
+BufferedFile::~BufferedFile()
+{
+    try
+    {
+        flush();
+    }
+    catch(const std::exception& e)
+    {
+        (void)e;
+    }
+}
+
+void BufferedFile::writeAll(const char* ptr, size_t count)
+{
+    while (count > 0)
+    {
+        ssize_t n = m_file.write(ptr,count);
+        ptr += n;
+        count -= n;
+    }
+}
+
+void BufferedFile::setMode(Mode mode)
+{
+    if (m_mode == mode)
+    {
+        return;
+    }
+    if (m_mode == WRITING)
+    {
+        flush();
+    }
+    else if (m_mode == READING and m_end > m_begin)
+    {
+        // Give the read-ahead back so the next write lands at the logical position
+        try
+        {
+            m_file.lseek(-off_t(m_end-m_begin),SEEK_CUR);
+        }
+        catch(const PosixError& e)
+        {
+            if (e.errnoVal() != ESPIPE)
+            {
+                throw;
+            }
+        }
+    }
+    m_begin = 0;
+    m_end = 0;
+    m_mode = mode;
+}
+
+ssize_t BufferedFile::write(const void *buf, size_t count)
+{
+    setMode(WRITING);
+    const char* ptr = static_cast<const char*>(buf);
+    if (m_end + count > m_buf.size())
+    {
+        flush();
+        m_mode = WRITING;
+        if (count >= m_buf.size())
+        {
+            // Too big to be worth buffering
+            writeAll(ptr,count);
+            return count;
+        }
+    }
+    memcpy(&m_buf[m_end],ptr,count);
+    m_end += count;
+    return count;
+}
+
+void BufferedFile::flush()
+{
+    if (m_mode != WRITING)
+    {
+        return;
+    }
+    // Only what was written leaves the buffer, a retry after an error (e.g. EAGAIN) writes the rest
+    size_t done = 0;
+    try
+    {
+        while (done < m_end)
+        {
+            done += m_file.write(&m_buf[done],m_end-done);
+        }
+    }
+    catch (...)
+    {
+        memmove(&m_buf[0],&m_buf[done],m_end-done);
+        m_end -= done;
+        throw;
+    }
+    m_end = 0;
+    m_mode = IDLE;
+}
+
+size_t BufferedFile::fill()
+{
+    if (m_begin == m_end)
+    {
+        m_begin = 0;
+        m_end = 0;
+    }
+    ssize_t n = m_file.read(&m_buf[m_end],m_buf.size()-m_end);
+    m_end += n;
+    return n;
+}
+
+ssize_t BufferedFile::read(void *buf, size_t count)
+{
+    setMode(READING);
+    char* ptr = static_cast<char*>(buf);
+    if (m_begin == m_end)
+    {
+        if (count >= m_buf.size())
+        {
+            // Large reads bypass the buffer
+            return m_file.read(static_cast<void*>(ptr),count);
+        }
+        if (fill() == 0)
+        {
+            return 0;
+        }
+    }
+    size_t n = std::min(count,m_end-m_begin);
+    memcpy(ptr,&m_buf[m_begin],n);
+    m_begin += n;
+    return n;
+}
+
+std::optional<std::string_view> BufferedFile::readUntil(char delim)
+{
+    setMode(READING);
+    size_t scanned = 0; // bytes of the unread window already searched
+    while (true)
+    {
+        const char* start = &m_buf[m_begin];
+        const void* found = memchr(start+scanned,delim,m_end-m_begin-scanned);
+        if (found != nullptr)
+        {
+            size_t len = static_cast<const char*>(found)-start;
+            m_begin += len+1;
+            return std::string_view(start,len);
+        }
+        scanned = m_end-m_begin;
+
+        if (m_end == m_buf.size())
+        {
+            if (m_begin > 0)
+            {
+                // Slide the partial record to the front to make room
+                memmove(&m_buf[0],&m_buf[m_begin],m_end-m_begin);
+                m_end -= m_begin;
+                m_begin = 0;
+            }
+            else
+            {
+                // The record is longer than the buffer
+                m_buf.resize(2*m_buf.size());
+            }
+        }
+        if (fill() == 0)
+        {
+            break;
+        }
+    }
+
+    // End of file, hand back any trailing record without a delimiter
+    if (m_begin == m_end)
+    {
+        return std::nullopt;
+    }
+    std::string_view ret(&m_buf[m_begin],m_end-m_begin);
+    m_begin = m_end;
+    return ret;
+}
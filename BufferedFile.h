@@ -0,0 +1,88 @@
+#ifndef BUFFEREDFILE_H
+#define BUFFEREDFILE_H
+
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "File.h"
+
+namespace posixcpp
+{
+
+/*
+** User-space buffering on top of a File, to turn many small reads and writes
+** into few large read(2)/write(2) calls. Writes are held until flush(), a full
+** buffer, or destruction. Switching between reading and writing discards
+** read-ahead, seeking back over it where the file allows.
+** Not thread safe. Throws PosixError like File, except in the destructor.
+*/
+class BufferedFile
+{
+protected:
+    enum Mode {IDLE,READING,WRITING};
+
+    File& m_file;
+    std::vector<char> m_buf;
+    size_t m_begin;  // start of unread data (READING)
+    size_t m_end;    // end of unread data (READING) or of unwritten data (WRITING)
+    Mode m_mode;
+
+    void writeAll(const char* ptr, size_t count);
+    void setMode(Mode mode);
+    // Read more data after m_end. Returns the bytes read, 0 at end of file
+    size_t fill();
+
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 64*1024;
+
+    /// The File must outlive the BufferedFile
+    BufferedFile(File& file, size_t bufferSize=DEFAULT_BUFFER_SIZE);
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    /// Flushes pending writes. Errors are ignored, call flush() first to see them
+    ~BufferedFile();
+
+    /// The underlying File
+    File& file() {return m_file;};
+
+    /// Capacity of the buffer
+    size_t bufferSize() const {return m_buf.size();};
+
+    /// Buffered write. Always accepts all count bytes
+    ssize_t write(const void *buf, size_t count);
+
+    /// Buffered write using a std::vector, std::string or std::array
+    template <typename Typ>
+    ssize_t write(const Typ& data)
+    {
+        size_t elemSize = sizeof(typename Typ::value_type);
+        write(&data[0],data.size()*elemSize);
+        return data.size();
+    };
+
+    /// Write out everything buffered. On error the unwritten data stays buffered for another flush()
+    void flush();
+
+    /// Buffered read. Returns 0 at end of file, may return less than count like read(2)
+    ssize_t read(void *buf, size_t count);
+
+    /*
+    ** Returns the data up to (not including) delim, or up to end of file for
+    ** the last record. Returns std::nullopt at end of file. The view points into
+    ** the buffer and is only valid until the next call on this object.
+    ** The buffer grows only if a record is longer than it.
+    */
+    std::optional<std::string_view> readUntil(char delim);
+
+    /// readUntil('\n')
+    std::optional<std::string_view> readLine()
+    {
+        return readUntil('\n');
+    };
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include <cstring>
+#include "PosixError.h"
+#include "DatagramBatch.h"
+
+using namespace posixcpp;
+
+DatagramBatch::DatagramBatch(unsigned numSlots, size_t slotSize)
+: m_slotSize(slotSize),
+  m_buffers(numSlots*slotSize),
+  m_iovs(numSlots),
+  m_addrs(numSlots),
+  m_msgs(numSlots)
+{
+    if (numSlots == 0)
+    {
+        throw PosixError("DatagramBatch needs at least one slot",EINVAL);
+    }
+    for (unsigned i=0; i<numSlots; i++)
+    {
+        m_iovs[i].iov_base = data(i);
+        m_iovs[i].iov_len = m_slotSize;
+        msghdr& hdr = m_msgs[i].msg_hdr;
+        memset(&hdr,0,sizeof(hdr));
+        hdr.msg_iov = &m_iovs[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_name = &m_addrs[i];
+        hdr.msg_namelen = 0;
+        m_msgs[i].msg_len = 0;
+    }
+}
+
+void DatagramBatch::setSize(unsigned i, size_t len)
+{
+    if (len > m_slotSize)
+    {
+        throw PosixError("DatagramBatch::setSize larger than the slot",EMSGSIZE);
+    }
+    m_iovs[i].iov_len = len;
+}
+
+void DatagramBatch::setAddr(unsigned i, const sockaddr* addr, socklen_t len)
+{
+    if (len > sizeof(sockaddr_storage))
+    {
+        throw PosixError("DatagramBatch::setAddr",EINVAL);
+    }
+    memcpy(&m_addrs[i],addr,len);
+    m_msgs[i].msg_hdr.msg_namelen = len;
+}
+
+void DatagramBatch::clearAddr(unsigned i)
+{
+    m_msgs[i].msg_hdr.msg_namelen = 0;
+}
+
+void DatagramBatch::prepareRecv(unsigned count)
+{
+    for (unsigned i=0; i<count; i++)
+    {
+        m_iovs[i].iov_len = m_slotSize;
+        m_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        m_msgs[i].msg_hdr.msg_flags = 0;
+    }
+}
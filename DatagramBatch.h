@@ -0,0 +1,71 @@
+#ifndef DATAGRAMBATCH_H
+#define DATAGRAMBATCH_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <vector>
+
+namespace posixcpp
+{
+
+/*
+** Caller-owned message slots for Socket::sendBatch()/recvBatch().
+** All memory is allocated once in the constructor, so the batch calls
+** themselves never allocate. Each slot holds one datagram of up to slotSize bytes.
+*/
+class DatagramBatch
+{
+protected:
+    size_t m_slotSize;
+    std::vector<char> m_buffers;
+    std::vector<iovec> m_iovs;
+    std::vector<sockaddr_storage> m_addrs;
+    std::vector<mmsghdr> m_msgs;
+
+public:
+    DatagramBatch(unsigned numSlots, size_t slotSize);
+
+    DatagramBatch(const DatagramBatch&) = delete;
+    DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+    /// Number of slots
+    unsigned capacity() const {return m_msgs.size();};
+
+    /// Size of each slot buffer in bytes
+    size_t slotSize() const {return m_slotSize;};
+
+    /// Payload buffer of slot i, slotSize() bytes long
+    char* data(unsigned i) {return &m_buffers[i*m_slotSize];};
+
+    const char* data(unsigned i) const {return &m_buffers[i*m_slotSize];};
+
+    /// Bytes received into (or sent from) slot i by the last batch call
+    size_t size(unsigned i) const {return m_msgs[i].msg_len;};
+
+    /// True if the datagram in slot i was longer than slotSize() and got truncated
+    bool truncated(unsigned i) const {return m_msgs[i].msg_hdr.msg_flags & MSG_TRUNC;};
+
+    /// Source address of a received datagram, or destination set with setAddr()
+    const sockaddr* addr(unsigned i) const {return reinterpret_cast<const sockaddr*>(&m_addrs[i]);};
+
+    socklen_t addrLen(unsigned i) const {return m_msgs[i].msg_hdr.msg_namelen;};
+
+    /// Set the number of bytes of data(i) to send
+    void setSize(unsigned i, size_t len);
+
+    /// Set the destination of slot i. Not needed on a connected socket
+    void setAddr(unsigned i, const sockaddr* addr, socklen_t len);
+
+    /// Send slot i to the connected peer
+    void clearAddr(unsigned i);
+
+    /// Reset every slot to receive a full slotSize() datagram and its source address
+    void prepareRecv(unsigned count);
+
+    /// Raw mmsghdr array for sendmmsg(2)/recvmmsg(2)
+    mmsghdr* msgs() {return &m_msgs[0];};
+};
+
+}
+
+#endif
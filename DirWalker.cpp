@@ -0,0 +1,285 @@
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "DirWalker.h"
+#include "PosixError.h"
+
+using namespace posixcpp;
+
+namespace
+{
+
+// Record layout of getdents64(2)
+struct linux_dirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// The root may be a symlink to a directory, the entries below it are not followed
+const int c_rootFlags = O_RDONLY|O_DIRECTORY|O_CLOEXEC;
+const int c_dirFlags = c_rootFlags|O_NOFOLLOW;
+
+size_t defaultMaxOpenDirs()
+{
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE,&limit) != 0 or limit.rlim_cur == RLIM_INFINITY)
+    {
+        return 1024;
+    }
+    return std::max<size_t>(1,limit.rlim_cur/4);
+}
+
+}
+
+std::string DirWalker::Entry::path() const
+{
+    std::string ret = dir.filename();
+    ret += '/';
+    ret += name;
+    return ret;
+}
+
+struct statx DirWalker::Entry::statx(unsigned mask) const
+{
+    struct statx stx;
+    std::string nameStr(name);
+    int r = ::statx(dir.fd(),nameStr.c_str(),AT_SYMLINK_NOFOLLOW,mask,&stx);
+    PosixError::ASSERT(r==0,"statx");
+    return stx;
+}
+
+DirWalker::DirWalker(unsigned threads, size_t bufferSize, size_t maxOpenDirs)
+: m_threads(threads ? threads : std::max(1U,std::thread::hardware_concurrency())),
+  m_bufferSize(bufferSize),
+  m_maxOpenDirs(maxOpenDirs ? maxOpenDirs : defaultMaxOpenDirs()),
+  m_pending(0),
+  m_queued(0),
+  m_heldDirs(0),
+  m_stop(false)
+{
+}
+
+void DirWalker::push(unsigned worker, Task&& task)
+{
+    m_pending.fetch_add(1,std::memory_order_relaxed);
+    {
+        Worker& w = *m_workers[worker];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.tasks.push_back(std::move(task));
+    }
+    m_queued.fetch_add(1,std::memory_order_release);
+    wake(false);
+}
+
+void DirWalker::wake(bool all)
+{
+    // Taking the lock orders the change before a sleeper's predicate check
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+    }
+    if (all)
+    {
+        m_idle.notify_all();
+    }
+    else
+    {
+        m_idle.notify_one();
+    }
+}
+
+bool DirWalker::pop(unsigned worker, Task& task)
+{
+    // Own tasks newest first for locality, others' oldest first as they are the larger subtrees
+    for (unsigned i=0; i<m_workers.size(); i++)
+    {
+        Worker& w = *m_workers[(worker+i)%m_workers.size()];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.tasks.empty())
+        {
+            continue;
+        }
+        if (i == 0)
+        {
+            task = std::move(w.tasks.back());
+            w.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(w.tasks.front());
+            w.tasks.pop_front();
+        }
+        m_queued.fetch_sub(1,std::memory_order_relaxed);
+        if (task.parent)
+        {
+            m_heldDirs.fetch_sub(1,std::memory_order_relaxed);
+        }
+        return true;
+    }
+    return false;
+}
+
+void DirWalker::readDir(unsigned worker, Task& task, std::vector<char>& buffer, Stats& stats)
+{
+    File dir;
+    try
+    {
+        dir = task.parent ? task.parent->openat(task.name,c_dirFlags)
+                          : File(task.name,task.depth == 0 ? c_rootFlags : c_dirFlags);
+    }
+    catch (const PosixError& e)
+    {
+        if (task.depth == 0 or e.errnoVal() == EMFILE or e.errnoVal() == ENFILE)
+        {
+            throw; // the root, or out of fds - the rest of the walk would be lost silently
+        }
+        stats.errors++;
+        return;
+    }
+    // The parent is no longer needed, let it close as soon as its last child is open
+    task.parent = SharedFile();
+    stats.dirs++;
+
+    // Subdirectories share the open directory, it closes when the last one is opened
+    SharedFile shared(std::move(dir));
+    const File& self = *shared;
+    while (not m_stop.load(std::memory_order_relaxed))
+    {
+        long n = ::syscall(SYS_getdents64,self.fd(),&buffer[0],buffer.size());
+        if (n == -1)
+        {
+            stats.errors++;
+            return;
+        }
+        if (n == 0)
+        {
+            return;
+        }
+        for (long pos=0; pos<n; )
+        {
+            auto d = reinterpret_cast<const linux_dirent64*>(&buffer[pos]);
+            pos += d->d_reclen;
+            const char* name = d->d_name;
+            if (name[0] == '.' and (name[1] == '\0' or (name[1] == '.' and name[2] == '\0')))
+            {
+                continue;
+            }
+            unsigned char type = d->d_type;
+            if (type == DT_UNKNOWN)
+            {
+                struct stat st;
+                if (::fstatat(self.fd(),name,&st,AT_SYMLINK_NOFOLLOW) == 0)
+                {
+                    type = IFTODT(st.st_mode);
+                }
+            }
+            Entry entry{self,std::string_view(name),type,ino_t(d->d_ino),task.depth};
+            stats.entries++;
+            if (m_callback(entry) and type == DT_DIR)
+            {
+                if (m_heldDirs.fetch_add(1,std::memory_order_relaxed) < m_maxOpenDirs)
+                {
+                    push(worker,Task{shared,std::string(name),task.depth+1});
+                }
+                else
+                {
+                    m_heldDirs.fetch_sub(1,std::memory_order_relaxed);
+                    push(worker,Task{SharedFile(),entry.path(),task.depth+1});
+                }
+            }
+        }
+    }
+}
+
+void DirWalker::work(unsigned worker, Stats& stats)
+{
+    std::vector<char> buffer(m_bufferSize);
+    Task task;
+    while (not m_stop.load(std::memory_order_relaxed))
+    {
+        if (not pop(worker,task))
+        {
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            m_idle.wait(lock,[this]() {
+                return m_queued.load(std::memory_order_acquire) > 0 or
+                       m_pending.load(std::memory_order_acquire) == 0 or
+                       m_stop.load(std::memory_order_relaxed);
+            });
+            if (m_pending.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+            continue;
+        }
+        try
+        {
+            readDir(worker,task,buffer,stats);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (not m_error)
+            {
+                m_error = std::current_exception();
+            }
+            m_stop.store(true,std::memory_order_relaxed);
+            wake(true);
+        }
+        task = Task();
+        if (m_pending.fetch_sub(1,std::memory_order_acq_rel) == 1)
+        {
+            wake(true);
+        }
+    }
+}
+
+DirWalker::Stats DirWalker::walk(const std::string& root, callback_t callback)
+{
+    m_callback = callback;
+    m_workers.clear();
+    for (unsigned i=0; i<m_threads; i++)
+    {
+        m_workers.emplace_back(new Worker);
+    }
+    m_pending.store(0);
+    m_queued.store(0);
+    m_heldDirs.store(0);
+    m_stop.store(false);
+    m_error = nullptr;
+
+    push(0,Task{SharedFile(),root,0});
+    std::vector<Stats> stats(m_threads);
+    std::vector<std::thread> threads;
+    for (unsigned i=1; i<m_threads; i++)
+    {
+        threads.emplace_back([this,i,&stats]() {work(i,stats[i]);});
+    }
+    work(0,stats[0]);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    m_workers.clear();
+    m_callback = nullptr;
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+
+    Stats total;
+    for (auto& s : stats)
+    {
+        total.entries += s.entries;
+        total.dirs += s.dirs;
+        total.errors += s.errors;
+    }
+    return total;
+}
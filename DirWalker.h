@@ -0,0 +1,123 @@
+#ifndef DIRWALKER_H
+#define DIRWALKER_H
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "File.h"
+#include "SharedFile.h"
+
+namespace posixcpp
+{
+
+/*
+** Parallel recursive directory walk.
+** Each directory is opened once, with openat(2) relative to its parent, and
+** read in bulk with getdents64(2). Entry types come from d_type, falling back
+** to fstatat(2) only when the file system reports DT_UNKNOWN. Subdirectories
+** become tasks on per-thread deques; idle threads steal from the others and
+** sleep when there is nothing to steal. A queued task keeps its parent open
+** for the openat(2), up to maxOpenDirs of them; past that the task holds the
+** full path instead. Symbolic links are reported but not followed.
+*/
+class DirWalker
+{
+public:
+    /// One directory entry, valid only during the callback
+    struct Entry
+    {
+        const File& dir;          // the open directory holding the entry
+        std::string_view name;
+        unsigned char type;       // DT_REG, DT_DIR, DT_LNK, ...
+        ino_t ino;
+        unsigned depth;           // 0 for entries of the root
+
+        /// Path of the entry, the root path followed by the names down to it
+        std::string path() const;
+
+        bool isDir() const {return type == DT_DIR;};
+
+        /// Wrapper for statx(2) on the entry relative to dir, not following symlinks
+        struct statx statx(unsigned mask=STATX_BASIC_STATS) const;
+    };
+
+    /*
+    ** Called for every entry, from several threads at once. For directories
+    ** return false to skip their contents. An exception stops the walk and is
+    ** rethrown by walk().
+    */
+    typedef std::function<bool(const Entry& entry)> callback_t;
+
+    struct Stats
+    {
+        uint64_t entries = 0;
+        uint64_t dirs = 0;    // directories read, including the root
+        uint64_t errors = 0;  // subdirectories that could not be opened or read, except EMFILE/ENFILE which throw
+    };
+
+protected:
+    struct Task
+    {
+        SharedFile parent;  // empty for the root and tasks over the open directory budget
+        std::string name;   // relative to parent, or the full path
+        unsigned depth;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    unsigned m_threads;
+    size_t m_bufferSize;
+    size_t m_maxOpenDirs;
+
+    // State of the current walk
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<uint64_t> m_pending;    // tasks queued or running
+    std::atomic<uint64_t> m_queued;     // tasks queued
+    std::atomic<uint64_t> m_heldDirs;   // queued tasks holding their parent open
+    std::atomic<bool> m_stop;
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;     // signalled on push, on the last task done and on stop
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+    callback_t m_callback;
+
+    void push(unsigned worker, Task&& task);
+    bool pop(unsigned worker, Task& task);
+    void wake(bool all);
+    void work(unsigned worker, Stats& stats);
+    void readDir(unsigned worker, Task& task, std::vector<char>& buffer, Stats& stats);
+
+public:
+    /*
+    ** threads=0 uses one per cpu. bufferSize is the getdents64(2) buffer per
+    ** thread. maxOpenDirs bounds the directories kept open by queued tasks,
+    ** 0 uses a quarter of RLIMIT_NOFILE.
+    */
+    DirWalker(unsigned threads=0, size_t bufferSize=64*1024, size_t maxOpenDirs=0);
+
+    DirWalker(const DirWalker&) = delete;
+    DirWalker& operator=(const DirWalker&) = delete;
+
+    unsigned threads() const {return m_threads;};
+
+    /// Walk the tree below root, calling callback for each entry. Throws PosixError if root cannot be read or fds run out
+    Stats walk(const std::string& root, callback_t callback);
+};
+
+}
+
+#endif
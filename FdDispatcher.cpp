@@ -0,0 +1,57 @@
+#include <cerrno>
+#include "FdDispatcher.h"
+#include "PosixError.h"
+
+using namespace posixcpp;
+
+FdDispatcher::FdDispatcher(unsigned workers)
+: m_next(0)
+{
+    if (workers == 0)
+    {
+        throw PosixError("FdDispatcher needs at least one worker",EINVAL);
+    }
+    for (unsigned i=0; i<workers; i++)
+    {
+        m_channels.emplace_back(AF_UNIX,SOCK_SEQPACKET|SOCK_CLOEXEC);
+    }
+}
+
+void FdDispatcher::acceptorSide()
+{
+    for (auto& channel : m_channels)
+    {
+        channel.reader().close();
+    }
+}
+
+File FdDispatcher::workerSide(unsigned i)
+{
+    if (i >= m_channels.size())
+    {
+        throw PosixError("FdDispatcher::workerSide",EINVAL);
+    }
+    File channel = std::move(m_channels[i].reader());
+    m_channels.clear();
+    return channel;
+}
+
+unsigned FdDispatcher::dispatch(std::span<const File> files)
+{
+    if (m_channels.empty())
+    {
+        throw PosixError("FdDispatcher::dispatch",EINVAL);
+    }
+    unsigned worker = m_next;
+    m_next = (m_next+1)%m_channels.size();
+    m_channels[worker].sendFds(files);
+    return worker;
+}
+
+void FdDispatcher::shutdown()
+{
+    for (auto& channel : m_channels)
+    {
+        channel.writer().close();
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef FDDISPATCHER_H
+#define FDDISPATCHER_H
+
+#include <span>
+#include <vector>
+#include "File.h"
+#include "SocketPair.h"
+
+namespace posixcpp
+{
+
+/*
+** Hands accepted connections from one acceptor process to pre-forked workers,
+** so only the acceptor waits on the listening socket (no thundering herd).
+** Each worker has a SOCK_SEQPACKET SocketPair; connections go out round robin
+** with SCM_RIGHTS. Create the dispatcher before forking, then call
+** acceptorSide() in the acceptor and workerSide(i) in worker i.
+*/
+class FdDispatcher
+{
+protected:
+    std::vector<SocketPair> m_channels;
+    size_t m_next;
+
+public:
+    FdDispatcher(unsigned workers);
+
+    unsigned workers() const {return m_channels.size();};
+
+    /// In the acceptor after fork: close the worker ends of the channels
+    void acceptorSide();
+
+    /// In worker i after fork: close every other end, return the channel to receive() on
+    File workerSide(unsigned i);
+
+    /*
+    ** Send files to the next worker. Returns the worker index. Batches over
+    ** SCM_MAX_FDS are split across several messages, each one receive() in the
+    ** worker. The worker gets its own descriptors, so the caller should close
+    ** its copies. Throws EINVAL after workerSide(), which drops the channels.
+    */
+    unsigned dispatch(std::span<const File> files);
+
+    unsigned dispatch(const File& file)
+    {
+        return dispatch(std::span<const File>(&file,1));
+    };
+
+    /// Close the acceptor ends, so each worker's receive() returns an empty vector
+    void shutdown();
+
+    /// In a worker: wait for the next batch of descriptors. Empty once the acceptor has shut down
+    static std::vector<File> receive(const File& channel, size_t maxFds=SCM_MAX_FDS)
+    {
+        return recvFds(channel.fd(),maxFds);
+    };
+};
+
+}
+
+#endif
@@ -13,11 +13,12 @@
 #include <cassert>
 #include "PosixError.h"
 #include "File.h"
+#include "Metrics.h"
 
 using namespace posixcpp;
 
 File::File(const std::string& filename, int posixFlags, int mode)
-: m_filename(normalizePath(filename)),
+: m_path(filename),
   m_fd(open(filename.c_str(),posixFlags,mode)),
   m_fromFilename(true)
 {
@@ -25,18 +26,40 @@ File::File(const std::string& filename, int posixFlags, int mode)
     {
         throw PosixError(filename);
     }
-    fstat();
     m_mode = ::fcntl(m_fd,F_GETFL)&MODE_MASK;
+    if (m_mode & O_DIRECT)
+    {
+        directAlignment(m_dioMemAlign,m_dioOffsetAlign);
+    }
+}
+
+File::File(const Path& path, int posixFlags, int mode)
+: m_path(path),
+  m_fd(open(path.c_str(),posixFlags,mode)),
+  m_fromFilename(true)
+{
+    if (m_fd == -1)
+    {
+        throw PosixError(path.str());
+    }
+    m_mode = ::fcntl(m_fd,F_GETFL)&MODE_MASK;
+    if (m_mode & O_DIRECT)
+    {
+        directAlignment(m_dioMemAlign,m_dioOffsetAlign);
+    }
 }
 
 File::File(int fd, const std::string& filename)
-: m_filename(normalizePath(filename)),
+: m_path(filename),
   m_fd(fd),
   m_mode(::fcntl(m_fd,F_GETFL)&MODE_MASK),
-  m_stat(fstat(true)),
   m_fromFilename(false)
 {
     PosixError::ASSERT(fd >= 0,"File(fd)");
+    if (m_mode & O_DIRECT)
+    {
+        directAlignment(m_dioMemAlign,m_dioOffsetAlign);
+    }
 }
 
 File::File() noexcept
@@ -46,16 +69,36 @@ File::File() noexcept
 {
 }
 
+void File::copyStat(const File& other)
+{
+    if (other.m_statState.load(std::memory_order_acquire) == STAT_READY)
+    {
+        m_stat = other.m_stat;
+        m_statState.store(STAT_READY,std::memory_order_relaxed);
+    }
+    else
+    {
+        m_statState.store(STAT_EMPTY,std::memory_order_relaxed);
+    }
+}
+
 File::~File()
 {
-    ::close(m_fd);
+    if (m_fd != -1)
+    {
+        ::close(m_fd);
+    }
 }
 
 File::File(const File& other) noexcept // copy
-: m_filename(other.m_filename),
+: m_path(other.m_path),
   m_fd(::dup(other.m_fd)),
-  m_mode(::fcntl(m_fd,F_GETFL)&MODE_MASK)
+  m_mode(other.m_mode),
+  m_fromFilename(other.m_fromFilename),
+  m_dioMemAlign(other.m_dioMemAlign),
+  m_dioOffsetAlign(other.m_dioOffsetAlign)
 {
+    copyStat(other);
 }
 
 File& File::operator=(const File& other) noexcept // copy
@@ -64,26 +107,34 @@ File& File::operator=(const File& other) noexcept // copy
     {
         return *this;
     }
-    ::close(m_fd);
-    m_filename = other.m_filename;
-    m_fd = other.m_fd;
-    m_mode = ::fcntl(m_fd,F_GETFL)&MODE_MASK;
-    m_stat = other.m_stat;
+    close();
+    m_path = other.m_path;
+    m_fd = ::dup(other.m_fd);
+    m_mode = other.m_mode;
+    copyStat(other);
     m_fromFilename = other.m_fromFilename;
+    m_dioMemAlign = other.m_dioMemAlign;
+    m_dioOffsetAlign = other.m_dioOffsetAlign;
     return *this;
 }
 
+// Moves carry the cached mode and stat over, so they make no syscalls
 File::File(File&& other) noexcept // move
-: m_filename(other.m_filename),
+: m_path(std::move(other.m_path)),
   m_fd(other.m_fd),
-  m_mode(::fcntl(m_fd,F_GETFL)&MODE_MASK),
-  m_fromFilename(other.m_fromFilename)
+  m_mode(other.m_mode),
+  m_fromFilename(other.m_fromFilename),
+  m_dioMemAlign(other.m_dioMemAlign),
+  m_dioOffsetAlign(other.m_dioOffsetAlign)
 {
+    copyStat(other);
     other.m_fd = -1;
-    other.m_filename.clear();
+    other.m_path = Path();
     other.m_mode = 0;
-    struct stat zz{0};
-    other.m_stat = zz;
+    other.m_dioMemAlign = 0;
+    other.m_dioOffsetAlign = 0;
+    other.m_stat = {};
+    other.m_statState.store(STAT_READY,std::memory_order_relaxed);
 }
 
 File& File::operator=(File&& other) noexcept // move
@@ -93,32 +144,176 @@ File& File::operator=(File&& other) noexcept // move
         return *this;
     }
 
-    ::close(m_fd);
-    m_filename = other.m_filename;
+    close();
+    m_path = std::move(other.m_path);
     m_fd = other.m_fd;
-    m_mode = ::fcntl(m_fd,F_GETFL)&MODE_MASK;
-    m_stat = other.m_stat;
+    m_mode = other.m_mode;
+    copyStat(other);
     m_fromFilename = other.m_fromFilename;
+    m_dioMemAlign = other.m_dioMemAlign;
+    m_dioOffsetAlign = other.m_dioOffsetAlign;
     other.m_fd = -1;
-    other.m_filename.clear();
+    other.m_path = Path();
     other.m_mode = 0;
+    other.m_dioMemAlign = 0;
+    other.m_dioOffsetAlign = 0;
+    other.m_stat = {};
+    other.m_statState.store(STAT_READY,std::memory_order_relaxed);
     return *this;
 }
 
 ssize_t File::read(void *buf, size_t count) const
 {
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(buf,count,-1,"read");
+    }
+    POSIXCPP_METRIC_START();
     ssize_t ret = ::read(m_fd,buf,count);
+    POSIXCPP_METRIC_END(FILE_READ,ret);
     PosixError::ASSERT(ret!=-1,"read");
     return ret;
 }
 
 ssize_t File::write(const void *buf, size_t count) const
 {
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(buf,count,-1,"write");
+    }
+    POSIXCPP_METRIC_START();
     ssize_t ret = ::write(m_fd,buf,count);
+    POSIXCPP_METRIC_END(FILE_WRITE,ret);
     PosixError::ASSERT(ret!=-1,"write");
     return ret;
 }
 
+ssize_t File::readv(std::span<const iovec> iov) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(iov,-1,"readv");
+    }
+    ssize_t ret = ::readv(m_fd,iov.data(),iov.size());
+    PosixError::ASSERT(ret!=-1,"readv");
+    return ret;
+}
+
+ssize_t File::writev(std::span<const iovec> iov) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(iov,-1,"writev");
+    }
+    ssize_t ret = ::writev(m_fd,iov.data(),iov.size());
+    PosixError::ASSERT(ret!=-1,"writev");
+    return ret;
+}
+
+ssize_t File::pread(void *buf, size_t count, off_t offset) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(buf,count,offset,"pread");
+    }
+    ssize_t ret = ::pread(m_fd,buf,count,offset);
+    PosixError::ASSERT(ret!=-1,"pread");
+    return ret;
+}
+
+ssize_t File::pwrite(const void *buf, size_t count, off_t offset) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(buf,count,offset,"pwrite");
+    }
+    ssize_t ret = ::pwrite(m_fd,buf,count,offset);
+    PosixError::ASSERT(ret!=-1,"pwrite");
+    return ret;
+}
+
+ssize_t File::preadv2(std::span<const iovec> iov, off_t offset, int flags) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(iov,offset,"preadv2");
+    }
+    ssize_t ret = ::preadv2(m_fd,iov.data(),iov.size(),offset,flags);
+    PosixError::ASSERT(ret!=-1,"preadv2");
+    return ret;
+}
+
+ssize_t File::pwritev2(std::span<const iovec> iov, off_t offset, int flags) const
+{
+    if (m_mode & O_DIRECT)
+    {
+        checkDirect(iov,offset,"pwritev2");
+    }
+    ssize_t ret = ::pwritev2(m_fd,iov.data(),iov.size(),offset,flags);
+    PosixError::ASSERT(ret!=-1,"pwritev2");
+    return ret;
+}
+
+Result<ssize_t> File::tryRead(void *buf, size_t count) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(buf,count,-1))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    POSIXCPP_METRIC_START();
+    ssize_t ret = ::read(m_fd,buf,count);
+    POSIXCPP_METRIC_END(FILE_READ,ret);
+    return syscallResult(ret);
+}
+
+Result<ssize_t> File::tryWrite(const void *buf, size_t count) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(buf,count,-1))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    POSIXCPP_METRIC_START();
+    ssize_t ret = ::write(m_fd,buf,count);
+    POSIXCPP_METRIC_END(FILE_WRITE,ret);
+    return syscallResult(ret);
+}
+
+Result<ssize_t> File::tryReadv(std::span<const iovec> iov) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(iov,-1))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    return syscallResult(::readv(m_fd,iov.data(),iov.size()));
+}
+
+Result<ssize_t> File::tryWritev(std::span<const iovec> iov) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(iov,-1))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    return syscallResult(::writev(m_fd,iov.data(),iov.size()));
+}
+
+Result<ssize_t> File::tryPread(void *buf, size_t count, off_t offset) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(buf,count,offset))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    return syscallResult(::pread(m_fd,buf,count,offset));
+}
+
+Result<ssize_t> File::tryPwrite(const void *buf, size_t count, off_t offset) const noexcept
+{
+    if ((m_mode & O_DIRECT) and not directAligned(buf,count,offset))
+    {
+        return Result<ssize_t>(std::error_code(EINVAL,std::generic_category()));
+    }
+    return syscallResult(::pwrite(m_fd,buf,count,offset));
+}
+
 int File::close() noexcept
 {
     int fd = m_fd;
@@ -130,13 +325,20 @@ int File::close() noexcept
     return ::close(fd);
 };
 
+int File::release() noexcept
+{
+    int fd = m_fd;
+    m_fd = -1;
+    return fd;
+}
+
 off_t File::lseek(off_t offset, int whence) const
 {
     off_t ret = ::lseek(m_fd,offset,whence);
     if (ret == -1)
     {
         std::ostringstream oss;
-        oss << "lseek failed (" << m_filename << ")";
+        oss << "lseek failed (" << m_path.view() << ")";
         throw PosixError(oss.str());
     }
     return ret;
@@ -150,7 +352,9 @@ void File::ftruncate(off_t length)
 
 void File::fsync()
 {
+    POSIXCPP_METRIC_START();
     int r = ::fsync(m_fd);
+    POSIXCPP_METRIC_END(FILE_FSYNC,r);
     PosixError::ASSERT(r!=-1,"fsync");
 }
 
@@ -160,9 +364,150 @@ void File::fdatasync()
     PosixError::ASSERT(r!=-1,"fdatasync");
 }
 
+void File::fallocate(off_t offset, off_t len, int mode)
+{
+    int r = ::fallocate(m_fd,mode,offset,len);
+    PosixError::ASSERT(r!=-1,"fallocate");
+}
+
+void File::syncRange(off_t offset, off_t nbytes, unsigned flags)
+{
+    int r = ::sync_file_range(m_fd,offset,nbytes,flags);
+    PosixError::ASSERT(r!=-1,"sync_file_range");
+}
+
+void File::readahead(off_t offset, size_t count) const
+{
+    int r = ::readahead(m_fd,offset,count);
+    PosixError::ASSERT(r!=-1,"readahead");
+}
+
+void File::fadvise(off_t offset, off_t len, int advice) const
+{
+    // posix_fadvise returns the error rather than setting errno
+    int r = ::posix_fadvise(m_fd,offset,len,advice);
+    if (r != 0)
+    {
+        throw PosixError("posix_fadvise",r);
+    }
+}
+
+void File::setDirect(bool on)
+{
+    int flags = ::fcntl(m_fd,F_GETFL);
+    PosixError::ASSERT(flags!=-1,"fcntl");
+    flags = on ? (flags|O_DIRECT) : (flags&~O_DIRECT);
+    if (on and m_dioMemAlign == 0)
+    {
+        directAlignment(m_dioMemAlign,m_dioOffsetAlign);
+    }
+    int r = ::fcntl(m_fd,F_SETFL,flags);
+    PosixError::ASSERT(r!=-1,"fcntl O_DIRECT");
+    m_mode = (m_mode&~O_DIRECT)|(flags&O_DIRECT);
+}
+
+void File::directAlignment(uint32_t& memAlign, uint32_t& offsetAlign) const
+{
+    struct statx stx = statx(STATX_DIOALIGN);
+    if ((stx.stx_mask & STATX_DIOALIGN) and stx.stx_dio_offset_align != 0)
+    {
+        memAlign = stx.stx_dio_mem_align;
+        offsetAlign = stx.stx_dio_offset_align;
+    }
+    else
+    {
+        // Older kernels do not say, the block size is safe if stricter than needed
+        memAlign = offsetAlign = fstat().st_blksize;
+    }
+}
+
+size_t File::directMemAlign() const
+{
+    uint32_t memAlign = m_dioMemAlign;
+    uint32_t offsetAlign = m_dioOffsetAlign;
+    if (memAlign == 0)
+    {
+        directAlignment(memAlign,offsetAlign);
+    }
+    return memAlign;
+}
+
+size_t File::directOffsetAlign() const
+{
+    uint32_t memAlign = m_dioMemAlign;
+    uint32_t offsetAlign = m_dioOffsetAlign;
+    if (offsetAlign == 0)
+    {
+        directAlignment(memAlign,offsetAlign);
+    }
+    return offsetAlign;
+}
+
+const char* File::directMisalignment(const void* buf, size_t count, off_t offset, size_t& align) const noexcept
+{
+    // Filled when O_DIRECT was set, so concurrent const calls only read them
+    size_t memAlign = m_dioMemAlign;
+    size_t offsetAlign = m_dioOffsetAlign;
+    if (reinterpret_cast<uintptr_t>(buf) % memAlign != 0)
+    {
+        align = memAlign;
+        return "buffer address";
+    }
+    if (count % offsetAlign != 0)
+    {
+        align = offsetAlign;
+        return "length";
+    }
+    if (offset != -1 and offset % offsetAlign != 0)
+    {
+        align = offsetAlign;
+        return "offset";
+    }
+    return nullptr;
+}
+
+bool File::directAligned(const void* buf, size_t count, off_t offset) const noexcept
+{
+    size_t align;
+    return directMisalignment(buf,count,offset,align) == nullptr;
+}
+
+bool File::directAligned(std::span<const iovec> iov, off_t offset) const noexcept
+{
+    for (auto& v : iov)
+    {
+        if (not directAligned(v.iov_base,v.iov_len,offset))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void File::checkDirect(const void* buf, size_t count, off_t offset, const char* op) const
+{
+    size_t align = 0;
+    const char* what = directMisalignment(buf,count,offset,align);
+    if (what)
+    {
+        std::ostringstream oss;
+        oss << "O_DIRECT " << op << " (" << m_path.view() << "): " << what
+            << " not a multiple of " << align;
+        throw PosixError(oss.str(),EINVAL);
+    }
+}
+
+void File::checkDirect(std::span<const iovec> iov, off_t offset, const char* op) const
+{
+    for (auto& v : iov)
+    {
+        checkDirect(v.iov_base,v.iov_len,offset,op);
+    }
+}
+
 void File::unlink()
 {
-    int r = ::unlink(m_filename.c_str());
+    int r = ::unlink(m_path.c_str());
     if (r==-1 and errno != ENOENT)
     {
         throw PosixError("unlink failed");
@@ -171,7 +516,7 @@ void File::unlink()
 
 void File::remove()
 {
-    int r = ::remove(m_filename.c_str());
+    int r = ::remove(m_path.c_str());
     if (r==-1 and errno != ENOENT)
     {
         throw PosixError("remove failed");
@@ -180,26 +525,55 @@ void File::remove()
 
 struct stat File::fstat(bool force)
 {
-    if (not m_stat or force)
+    // Non-const, so no other thread is using this object
+    if (m_statState.load(std::memory_order_relaxed) != STAT_READY or force)
     {
-        struct stat sbuf;
-        int r = ::fstat(m_fd,&sbuf);
-        if (r == 0)
-        {
-            m_stat = sbuf;;
-        }
-        else
-        {
-            m_stat.reset();
-        }
+        int r = ::fstat(m_fd,&m_stat);
+        m_statState.store(r==0 ? STAT_READY : STAT_EMPTY,std::memory_order_release);
         PosixError::ASSERT(r==0,"fstat");
     }
-    return *m_stat;
+    return m_stat;
 }
 
 struct stat File::fstat() const
 {
-    return *m_stat;
+    if (m_statState.load(std::memory_order_acquire) == STAT_READY)
+    {
+        return m_stat;
+    }
+    struct stat sbuf;
+    int r = ::fstat(m_fd,&sbuf);
+    PosixError::ASSERT(r==0,"fstat");
+    // Concurrent const callers may all get here, only the first publishes its result
+    int expected = STAT_EMPTY;
+    if (m_statState.compare_exchange_strong(expected,STAT_FILLING,std::memory_order_acquire))
+    {
+        m_stat = sbuf;
+        m_statState.store(STAT_READY,std::memory_order_release);
+    }
+    return sbuf;
+}
+
+struct statx File::statx(unsigned mask, int flags) const
+{
+    struct statx stx;
+    int r = ::statx(m_fd,"",AT_EMPTY_PATH|flags,mask,&stx);
+    PosixError::ASSERT(r==0,"statx");
+    return stx;
+}
+
+std::vector<std::optional<struct statx>> File::statxAt(std::span<const std::string> names, unsigned mask, int flags) const
+{
+    std::vector<std::optional<struct statx>> ret(names.size());
+    for (size_t i=0; i<names.size(); i++)
+    {
+        struct statx stx;
+        if (::statx(m_fd,names[i].c_str(),flags,mask,&stx) == 0)
+        {
+            ret[i] = stx;
+        }
+    }
+    return ret;
 }
 
 bool File::fdValid() const
@@ -211,7 +585,7 @@ bool File::fdValid() const
 bool File::exists() const
 {
     struct stat sbuf;
-    int r = ::stat(m_filename.c_str(),&sbuf);
+    int r = ::stat(m_path.c_str(),&sbuf);
     return r==0;
 }
 
@@ -238,6 +612,18 @@ File File::mkdir(const std::string& path, mode_t mode)
     return File(path,O_RDONLY);
 }
 
+File File::openat(const std::string& name, int posixFlags, int perm) const
+{
+    int fd = ::openat(m_fd,name.c_str(),posixFlags,perm);
+    if (fd == -1)
+    {
+        throw PosixError(m_path.str()+"/"+name);
+    }
+    File ret(fd,m_path.str()+"/"+name);
+    ret.m_fromFilename = m_fromFilename;
+    return ret;
+}
+
 std::string File::getcwd()
 {
     char path[PATH_MAX+1];
@@ -253,51 +639,16 @@ File File::dup(int fd)
     return File(newFd);
 }
 
+File File::memfd_create(const std::string& name, unsigned flags)
+{
+    int fd = ::memfd_create(name.c_str(),flags);
+    PosixError::ASSERT(fd!=-1,"memfd_create");
+    return File(fd,name);
+}
+
 std::string File::normalizePath(const std::string& path)
 {
-    if (path.empty())
-    {
-        return "";
-    }
-    std::istringstream iss(path);
-    std::ostringstream oss;
-    while (iss)
-    {
-        std::string tok;
-        if (iss.eof())
-        {
-            break;
-        }
-        getline(iss,tok,'/');
-        if (oss.str().empty())
-        {
-            if (tok.empty())
-            {
-                oss << "/";
-            }
-            else if (tok == ".")
-            {
-                oss << ".";
-            }
-            else
-            {
-                oss << "./" << tok;
-            }
-        }
-        else if (tok.empty())
-        {
-            continue;
-        }
-        else
-        {
-            if (oss.str().back()!='/')
-            {
-                oss << '/';
-            }
-            oss << tok;
-        }
-    }
-    return oss.str();
+    return Path(path).str();
 }
 
 struct stat File::lstat(const std::string& filename)
@@ -316,41 +667,47 @@ size_t File::getSize(bool useCached)
 
 bool File::is_block_device() const
 {
-    return S_ISBLK((*m_stat).st_mode);
+    return S_ISBLK(fstat().st_mode);
 }
 
 bool File::is_char_device() const
 {
-    return S_ISCHR((*m_stat).st_mode);
+    return S_ISCHR(fstat().st_mode);
 }
 
 bool File::is_dir() const
 {
-    return S_ISDIR((*m_stat).st_mode);
+    return S_ISDIR(fstat().st_mode);
 }
 
 bool File::is_fifo() const
 {
-    return S_ISFIFO((*m_stat).st_mode);
+    return S_ISFIFO(fstat().st_mode);
 }
 
 bool File::is_file() const
 {
-    return S_ISREG((*m_stat).st_mode);
+    return S_ISREG(fstat().st_mode);
 }
 
 bool File::is_mount() const
 {
-    if (not is_dir())
+    struct statx stx = statx(STATX_TYPE);
+    if (not S_ISDIR(stx.stx_mode))
     {
         return false;
     }
-    return m_filename == "/" or fstat().st_dev != parent().fstat().st_dev;
+    if (stx.stx_attributes_mask & STATX_ATTR_MOUNT_ROOT)
+    {
+        return stx.stx_attributes & STATX_ATTR_MOUNT_ROOT;
+    }
+    // Kernels before 5.8 do not report it, compare with the parent's device
+    return m_path == "/" or fstat().st_dev != parent().fstat().st_dev;
 }
 
 bool File::is_socket() const
 {
-    return S_ISSOCK((*m_stat).st_mode);
+    return S_ISSOCK(fstat().st_mode);
 }
 
 bool File::is_symlink() const
@@ -364,7 +721,7 @@ bool File::is_symlink() const
     try
     {
         struct stat sbuf;
-        sbuf = lstat(m_filename);
+        sbuf = lstat(m_path.str());
         ret = S_ISLNK(sbuf.st_mode);
     }
     catch(const std::exception & e)
@@ -381,26 +738,12 @@ File File::parent() const
         throw PosixError("fd has no parent()",EINVAL);
     }
 
-    std::string path;
-
-    size_t n = m_filename.find_last_of("/");
-    File ret;
-    if (m_filename == ".")
+    if (not m_path.hasParent())
     {
         /// Special case - path == "."
-        ret = File(File::getcwd(),O_RDONLY).parent();
-    }
-    else if (n == 0 or m_filename == "/")
-    {
-        ret = File("/");
+        return File(File::getcwd(),O_RDONLY).parent();
     }
-    else
-    {
-        assert(n!=std::string::npos);
-        std::string p = m_filename.substr(0,n);
-        ret = File(m_filename.substr(0,n),O_RDONLY);
-    }
-    return ret;
+    return File(m_path.parent(),O_RDONLY);
 }
 
 std::ostream& operator<<(std::ostream& os, const File& file)
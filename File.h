@@ -1,8 +1,16 @@
 #include <unistd.h>
 #include <sys/file.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <atomic>
 #include <string>
+#include <span>
 #include <vector>
 #include <optional>
+#include "Path.h"
+#include "Result.h"
 
 #ifndef FILE_H
 #define FILE_H
@@ -17,14 +25,38 @@ namespace posixcpp
 class File
 {
 protected:
-    mutable std::string m_filename;
+    Path m_path;
     mutable int m_fd;
     mutable int m_mode;
-    std::optional<struct stat> m_stat;
+
+    // fstat(2) cache, filled on first use. Const callers publish it through m_statState
+    enum StatState {STAT_EMPTY,STAT_FILLING,STAT_READY};
+    mutable struct stat m_stat;
+    mutable std::atomic<int> m_statState{STAT_EMPTY};
+    void copyStat(const File& other);
+
     bool m_fromFilename; // true if constructed from filename
 
+    // O_DIRECT alignment of buffers and of offsets/lengths, filled when O_DIRECT is set
+    uint32_t m_dioMemAlign = 0;
+    uint32_t m_dioOffsetAlign = 0;
+
     // These are the only bits preserved by the File() object
-    static const int MODE_MASK = O_RDONLY|O_RDWR|O_WRONLY;
+    static const int MODE_MASK = O_RDONLY|O_RDWR|O_WRONLY|O_DIRECT;
+
+    // Throw EINVAL unless buf, count and offset meet the O_DIRECT alignment. offset=-1 is not checked
+    void checkDirect(const void* buf, size_t count, off_t offset, const char* op) const;
+    void checkDirect(std::span<const iovec> iov, off_t offset, const char* op) const;
+
+    // Which of buf, count and offset misses the O_DIRECT alignment, or nullptr. align is set to the one missed
+    const char* directMisalignment(const void* buf, size_t count, off_t offset, size_t& align) const noexcept;
+
+    // For the tryXyz() calls: false if the O_DIRECT alignment is not met
+    bool directAligned(const void* buf, size_t count, off_t offset) const noexcept;
+    bool directAligned(std::span<const iovec> iov, off_t offset) const noexcept;
+
+    // Query the O_DIRECT alignments with statx(2)
+    void directAlignment(uint32_t& memAlign, uint32_t& offsetAlign) const;
 
 public:
     static const int PERM_GRWX = 0777;
@@ -34,6 +66,9 @@ public:
     /// Calls open() on the given filename. Throws PosixError if open returns -1.
     File(const std::string& filename, int posixFlags=O_RDONLY, int perm=PERM_GRWX);
 
+    /// As above, with a path that is already normalized
+    File(const Path& path, int posixFlags=O_RDONLY, int perm=PERM_GRWX);
+
     /// Destructor will call close() on the input file descriptor
     File(int fd, const std::string& filename="unnamed");
 
@@ -49,14 +84,36 @@ public:
     File parent() const;
 
     /// Returns the filename given in the constructor
-    std::string filename() const {return m_filename;};
+    std::string filename() const {return m_path.str();};
+
+    /// Returns the normalized path given in the constructor
+    const Path& path() const {return m_path;};
 
     /// Returns the one and only file descriptor associated with this object
     int fd() const {return m_fd;};
 
-    /// Returns the mode flags (RWX) assocated with the file descriptor
+    /// Returns the mode flags (RWX) assocated with the file descriptor, plus O_DIRECT if set
     int mode() const {return m_mode;};
 
+    /*
+    ** Direct I/O (O_DIRECT) bypasses the page cache. Buffers, lengths and
+    ** offsets must then be aligned, see directMemAlign() and
+    ** directOffsetAlign(). The read and write calls check this before the
+    ** syscall and throw PosixError(EINVAL) saying what is misaligned. See
+    ** AlignedBufferPool for suitable buffers.
+    */
+    /// Returns true if the fd is in O_DIRECT mode
+    bool direct() const {return m_mode & O_DIRECT;};
+
+    /// Switch O_DIRECT on or off with fcntl(2). Throws EINVAL if the file system does not support it
+    void setDirect(bool on);
+
+    /// Required alignment of buffer addresses for direct I/O. Uses statx(2) STATX_DIOALIGN where supported
+    size_t directMemAlign() const;
+
+    /// Required alignment of file offsets and lengths for direct I/O
+    size_t directOffsetAlign() const;
+
     /// Returns true if the objects file descriptor is valid
     bool fdValid() const;
 
@@ -69,9 +126,52 @@ public:
     /// Wrapper for write(2)
     ssize_t write(const void *buf, size_t count) const;
 
+    /// Wrapper for readv(2). Reads at the current file offset
+    ssize_t readv(std::span<const iovec> iov) const;
+
+    /// Wrapper for writev(2). Writes at the current file offset
+    ssize_t writev(std::span<const iovec> iov) const;
+
+    /*
+    ** The positional calls below neither use nor move the file offset, so any
+    ** number of threads may use them concurrently on the same File
+    */
+    /// Wrapper for pread(2)
+    ssize_t pread(void *buf, size_t count, off_t offset) const;
+
+    /// Wrapper for pwrite(2)
+    ssize_t pwrite(const void *buf, size_t count, off_t offset) const;
+
+    /// Wrapper for preadv2(2). flags are RWF_xxx, e.g. RWF_NOWAIT or RWF_HIPRI. offset=-1 uses the file offset
+    ssize_t preadv2(std::span<const iovec> iov, off_t offset, int flags=0) const;
+
+    /// Wrapper for pwritev2(2). flags are RWF_xxx, e.g. RWF_DSYNC or RWF_HIPRI. offset=-1 uses the file offset
+    ssize_t pwritev2(std::span<const iovec> iov, off_t offset, int flags=0) const;
+
+    /*
+    ** noexcept versions of the calls above, returning the errno in a Result
+    ** instead of throwing. Meant for loops where errors are routine, such as
+    ** EAGAIN on a nonblocking fd. Direct I/O alignment is checked as in the
+    ** calls above, a misaligned request gives EINVAL without a syscall.
+    */
+    Result<ssize_t> tryRead(void *buf, size_t count) const noexcept;
+
+    Result<ssize_t> tryWrite(const void *buf, size_t count) const noexcept;
+
+    Result<ssize_t> tryReadv(std::span<const iovec> iov) const noexcept;
+
+    Result<ssize_t> tryWritev(std::span<const iovec> iov) const noexcept;
+
+    Result<ssize_t> tryPread(void *buf, size_t count, off_t offset) const noexcept;
+
+    Result<ssize_t> tryPwrite(const void *buf, size_t count, off_t offset) const noexcept;
+
     /// Wrapper for close(2). DOES NOT THROW
     int close() noexcept;
 
+    /// Give up ownership of the fd without closing it. Returns the fd, the object is left with fd -1
+    int release() noexcept;
+
     /// Wrapper for lseek(2)
     off_t lseek(off_t offset, int whence=SEEK_SET) const;
     
@@ -84,6 +184,28 @@ public:
     /// Wrapper for fdatasync(2)
     void fdatasync();
 
+    /*
+    ** Wrapper for fallocate(2). mode 0 allocates and extends the file,
+    ** FALLOC_FL_KEEP_SIZE allocates past the end without changing the size,
+    ** FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE frees a range and
+    ** FALLOC_FL_ZERO_RANGE zeroes one. Throws EOPNOTSUPP where the file system lacks a mode
+    */
+    void fallocate(off_t offset, off_t len, int mode=0);
+
+    /*
+    ** Wrapper for sync_file_range(2). SYNC_FILE_RANGE_WRITE starts writeback of
+    ** [offset,offset+nbytes) without waiting, add SYNC_FILE_RANGE_WAIT_BEFORE and
+    ** _WAIT_AFTER to wait for it. nbytes=0 means to the end of file. Makes no
+    ** metadata durable, so it does not replace fsync() or fdatasync()
+    */
+    void syncRange(off_t offset, off_t nbytes, unsigned flags=SYNC_FILE_RANGE_WRITE);
+
+    /// Wrapper for readahead(2), starts reading [offset,offset+count) into the page cache
+    void readahead(off_t offset, size_t count) const;
+
+    /// Wrapper for posix_fadvise(2). advice is POSIX_FADV_xxx, len=0 means to the end of file
+    void fadvise(off_t offset, off_t len, int advice) const;
+
     /// Wrapper for unlink(2). Does not throw if errno == ENOENT
     void unlink();
 
@@ -91,8 +213,9 @@ public:
     void remove();
 
     /**
-     ** The underlying fstat call occurs on the first call to fstat
-     ** and is never called again over the life of the object unless forced
+     ** The underlying fstat call occurs on the first call to fstat (or one of the is_xyz()
+     ** methods) and is never called again over the life of the object unless forced.
+     ** The const calls may race to fill the cache from several threads safely
      */
     /// Returns a cached value of fstat on the given fd. Use force=true to refresh the cached value
     struct stat fstat(bool force=false);
@@ -100,6 +223,17 @@ public:
     /// Const version of fstat (no force allowed)
     struct stat fstat() const;
 
+    /// Wrapper for statx(2) on the fd, asking only for the fields in mask (STATX_SIZE etc). Not cached
+    struct statx statx(unsigned mask=STATX_BASIC_STATS, int flags=0) const;
+
+    /*
+    ** statx(2) each of names relative to this directory, fetching only the
+    ** fields in mask. The result for a name is empty if the call failed for it.
+    */
+    std::vector<std::optional<struct statx>> statxAt(std::span<const std::string> names,
+                                                     unsigned mask=STATX_BASIC_STATS,
+                                                     int flags=AT_SYMLINK_NOFOLLOW) const;
+
     /// Wrapper for mkstemp(3)
     static File mkstemp(const std::string& templ);
 
@@ -109,13 +243,19 @@ public:
     /// Wrapper for mkdir(2)
     static File mkdir(const std::string& pathname, mode_t mode);
 
+    /// Wrapper for openat(2), opens name relative to this directory. The path is this path plus name
+    File openat(const std::string& name, int posixFlags=O_RDONLY, int perm=PERM_GRWX) const;
+
     /// Wrapper for getcwd(3)
     static std::string getcwd();
 
     // Wrapper for dup(2), throws PosixError on failure
     static File dup(int fd);
 
-    /// Remove duplicate slashes and trailing slashes. Return path start with '/' or './'
+    /// Wrapper for memfd_create(2), an anonymous file living in memory
+    static File memfd_create(const std::string& name, unsigned flags=MFD_CLOEXEC);
+
+    /// Remove duplicate slashes and trailing slashes. Return path start with '/' or './'. See Path
     static std::string normalizePath(const std::string& path);
 
     // \todo fcntl
@@ -158,6 +298,40 @@ public:
         return ret;
     };
 
+    /// Positional write using a std::vector, std::string or std::array
+    template <typename Typ>
+    ssize_t pwrite(const Typ& data, off_t offset) const
+    {
+        size_t elemSize = sizeof(typename Typ::value_type);
+        const void* buf = reinterpret_cast<const void*>(&data[0]);
+        auto n = pwrite(buf,data.size()*elemSize,offset);
+        return (n+elemSize-1)/elemSize;
+    };
+
+    /// Positional read using a std::vector or std::string
+    template <typename Typ>
+    ssize_t pread(Typ& data, off_t offset, size_t count=0) const
+    {
+        size_t elemSize = sizeof(typename Typ::value_type);
+        if (count == 0)
+        {
+            count = data.size();
+        }
+        else
+        {
+            data.resize(count);
+        }
+        void* buf = reinterpret_cast<void*>(&data[0]);
+        ssize_t ret = 0;
+        ssize_t n = pread(buf,count*elemSize,offset);
+        if (n > 0)
+        {
+            ret = (n+elemSize-1)/elemSize;
+        }
+        data.resize(ret);
+        return ret;
+    };
+
     // Read into a std::array
     template <typename Typ>
     ssize_t readArray(Typ& data) const
@@ -189,7 +363,7 @@ public:
     /// Return true if fd is a regular file. Uses cached fstat
     bool is_file() const;
 
-    /// Return true if fd is a mount point. Uses cached fstat
+    /// Return true if fd is a mount point. Uses statx(2) STATX_ATTR_MOUNT_ROOT where the kernel supports it
     bool is_mount() const;
 
     /// Return true if fd is a socket. Uses cached fstat
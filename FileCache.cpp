@@ -0,0 +1,119 @@
+#include <fcntl.h>
+#include "FileCache.h"
+#include "PosixError.h"
+
+using namespace posixcpp;
+
+FileCache::FileCache(size_t maxFds, clock_t::duration revalidateAfter)
+: m_maxFds(maxFds),
+  m_revalidateAfter(revalidateAfter)
+{
+    if (maxFds == 0)
+    {
+        throw PosixError("FileCache needs maxFds > 0",EINVAL);
+    }
+}
+
+bool FileCache::sameFile(const Entry& entry, const struct stat& st)
+{
+    return entry.dev == st.st_dev and entry.ino == st.st_ino and
+           entry.mtime.tv_sec == st.st_mtim.tv_sec and entry.mtime.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+FileCache::handle_t FileCache::insert(const std::string& key, handle_t file, const struct stat& st, clock_t::time_point now)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    m_lru.push_front(Entry{key,file,st.st_dev,st.st_ino,st.st_mtim,now});
+    m_index[key] = m_lru.begin();
+    while (m_lru.size() > m_maxFds)
+    {
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+        m_stats.evictions++;
+    }
+    return file;
+}
+
+FileCache::handle_t FileCache::get(const std::string& path)
+{
+    std::string key = File::normalizePath(path);
+    auto now = clock_t::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end() and now-it->second->checked < m_revalidateAfter)
+        {
+            m_lru.splice(m_lru.begin(),m_lru,it->second);
+            m_stats.hits++;
+            return it->second->file;
+        }
+    }
+
+    // Syscalls are made without holding the lock
+    struct stat st;
+    int r = ::stat(key.c_str(),&st);
+    if (r == -1)
+    {
+        erase(key);
+        throw PosixError(path);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            if (sameFile(*it->second,st))
+            {
+                it->second->checked = now;
+                m_lru.splice(m_lru.begin(),m_lru,it->second);
+                m_stats.hits++;
+                return it->second->file;
+            }
+            m_stats.invalidations++;
+        }
+    }
+
+    // fstat before sharing, so the File's stat cache is filled before any reader sees it
+    File opened(key,O_RDONLY|O_CLOEXEC);
+    st = opened.fstat();
+    handle_t file = std::make_shared<const File>(std::move(opened));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.misses++;
+    return insert(key,file,st,now);
+}
+
+void FileCache::erase(const std::string& path)
+{
+    std::string key = File::normalizePath(path);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+void FileCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    m_lru.clear();
+}
+
+size_t FileCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+FileCache::Stats FileCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
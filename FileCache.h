@@ -0,0 +1,93 @@
+#ifndef FILECACHE_H
+#define FILECACHE_H
+
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "File.h"
+
+namespace posixcpp
+{
+
+/*
+** Cache of read-only File objects keyed by File::normalizePath(path), so hot
+** files are opened once instead of on every request. Thread safe.
+**
+** At most maxFds entries are kept, the least recently used going first.
+** An evicted File stays open until the last handle to it is released, so
+** maxFds bounds the cache's own fds, not the process total: handles still
+** held by callers add to it.
+** An entry is revalidated with stat(2) once it is older than revalidateAfter,
+** one second by default. Zero means a stat(2) on every hit, which gives up
+** most of the syscall savings. If the inode or mtime changed the file is
+** opened again, so handles given out earlier keep referring to the old file.
+*/
+class FileCache
+{
+public:
+    typedef std::shared_ptr<const File> handle_t;
+    typedef std::chrono::steady_clock clock_t;
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;      // includes reopening a changed file
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0; // entries found changed on revalidation
+    };
+
+protected:
+    struct Entry
+    {
+        std::string key;
+        handle_t file;
+        dev_t dev;
+        ino_t ino;
+        timespec mtime;
+        clock_t::time_point checked;
+    };
+    typedef std::list<Entry> lru_t;
+
+    const size_t m_maxFds;
+    const clock_t::duration m_revalidateAfter;
+    mutable std::mutex m_mutex;
+    lru_t m_lru; // most recently used first
+    std::unordered_map<std::string,lru_t::iterator> m_index;
+    Stats m_stats;
+
+    static bool sameFile(const Entry& entry, const struct stat& st);
+
+    // Add or replace the entry for key, evicting as needed. Called with m_mutex held
+    handle_t insert(const std::string& key, handle_t file, const struct stat& st, clock_t::time_point now);
+
+public:
+    FileCache(size_t maxFds=1024, clock_t::duration revalidateAfter=std::chrono::seconds(1));
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    /// Returns a shared read-only File for path, opening it on a miss. Throws PosixError if it cannot be opened
+    handle_t get(const std::string& path);
+
+    /// Drop the entry for path, if any
+    void erase(const std::string& path);
+
+    /// Drop every entry
+    void clear();
+
+    /// Number of cached entries
+    size_t size() const;
+
+    size_t maxFds() const {return m_maxFds;};
+
+    Stats stats() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,297 @@
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+#include "PosixError.h"
+#include "MemMap.h"
+#include "IoRing.h"
+
+using namespace posixcpp;
+
+namespace
+{
+
+int io_uring_setup(unsigned entries, io_uring_params* params)
+{
+    return ::syscall(__NR_io_uring_setup,entries,params);
+}
+
+int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nrArgs)
+{
+    return ::syscall(__NR_io_uring_register,fd,opcode,arg,nrArgs);
+}
+
+template <typename Typ>
+Typ* ringPtr(const std::shared_ptr<char>& map, unsigned offset)
+{
+    return reinterpret_cast<Typ*>(map.get()+offset);
+}
+
+}
+
+IoRing::IoRing(unsigned entries, unsigned flags)
+: m_params{},
+  m_sqLocalTail(0),
+  m_pending(0)
+{
+    m_params.flags = flags;
+    int fd = io_uring_setup(entries,&m_params);
+    PosixError::ASSERT(fd!=-1,"io_uring_setup");
+    m_ring = File(fd,"io_uring");
+
+    size_t sqSize = m_params.sq_off.array + m_params.sq_entries*sizeof(unsigned);
+    size_t cqSize = m_params.cq_off.cqes + m_params.cq_entries*sizeof(io_uring_cqe);
+    if (m_params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        // One mapping covers both rings
+        sqSize = std::max(sqSize,cqSize);
+        m_sqMap = memMap<char>(m_ring,sqSize,IORING_OFF_SQ_RING);
+        m_cqMap = m_sqMap;
+    }
+    else
+    {
+        m_sqMap = memMap<char>(m_ring,sqSize,IORING_OFF_SQ_RING);
+        m_cqMap = memMap<char>(m_ring,cqSize,IORING_OFF_CQ_RING);
+    }
+    m_sqes = memMap<io_uring_sqe>(m_ring,m_params.sq_entries*sizeof(io_uring_sqe),IORING_OFF_SQES);
+
+    m_sqHead  = ringPtr<unsigned>(m_sqMap,m_params.sq_off.head);
+    m_sqTail  = ringPtr<unsigned>(m_sqMap,m_params.sq_off.tail);
+    m_sqMask  = ringPtr<unsigned>(m_sqMap,m_params.sq_off.ring_mask);
+    m_sqArray = ringPtr<unsigned>(m_sqMap,m_params.sq_off.array);
+    m_cqHead  = ringPtr<unsigned>(m_cqMap,m_params.cq_off.head);
+    m_cqTail  = ringPtr<unsigned>(m_cqMap,m_params.cq_off.tail);
+    m_cqMask  = ringPtr<unsigned>(m_cqMap,m_params.cq_off.ring_mask);
+    m_cqes    = ringPtr<io_uring_cqe>(m_cqMap,m_params.cq_off.cqes);
+    m_sqLocalTail = *m_sqTail;
+
+    // sqes are always filled in ring order, so the index array is the identity
+    for (unsigned i=0; i<m_params.sq_entries; i++)
+    {
+        m_sqArray[i] = i;
+    }
+}
+
+int IoRing::enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    int r;
+    do
+    {
+        r = ::syscall(__NR_io_uring_enter,m_ring.fd(),toSubmit,minComplete,flags,nullptr,0);
+    } while (r == -1 and errno == EINTR);
+    PosixError::ASSERT(r!=-1,"io_uring_enter");
+    return r;
+}
+
+io_uring_sqe* IoRing::getSqe()
+{
+    unsigned head = __atomic_load_n(m_sqHead,__ATOMIC_ACQUIRE);
+    if (m_sqLocalTail - head >= m_params.sq_entries)
+    {
+        // Full - hand what we have to the kernel to make room
+        submit();
+        head = __atomic_load_n(m_sqHead,__ATOMIC_ACQUIRE);
+        if (m_sqLocalTail - head >= m_params.sq_entries)
+        {
+            throw PosixError("io_uring submission queue full",EBUSY);
+        }
+    }
+    io_uring_sqe* sqe = &m_sqes.get()[m_sqLocalTail & *m_sqMask];
+    memset(sqe,0,sizeof(*sqe));
+    m_sqLocalTail++;
+    m_pending++;
+    return sqe;
+}
+
+io_uring_sqe* IoRing::prep(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t offset, uint64_t userData,
+                           bool fixedFile)
+{
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    if (fixedFile)
+    {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    return sqe;
+}
+
+void IoRing::registerFiles(const std::vector<int>& fds)
+{
+    int r = io_uring_register(m_ring.fd(),IORING_REGISTER_FILES,fds.data(),fds.size());
+    PosixError::ASSERT(r!=-1,"io_uring_register(IORING_REGISTER_FILES)");
+}
+
+void IoRing::unregisterFiles()
+{
+    int r = io_uring_register(m_ring.fd(),IORING_UNREGISTER_FILES,nullptr,0);
+    PosixError::ASSERT(r!=-1,"io_uring_register(IORING_UNREGISTER_FILES)");
+}
+
+void IoRing::registerBuffers(const std::vector<iovec>& buffers)
+{
+    int r = io_uring_register(m_ring.fd(),IORING_REGISTER_BUFFERS,buffers.data(),buffers.size());
+    PosixError::ASSERT(r!=-1,"io_uring_register(IORING_REGISTER_BUFFERS)");
+}
+
+void IoRing::unregisterBuffers()
+{
+    int r = io_uring_register(m_ring.fd(),IORING_UNREGISTER_BUFFERS,nullptr,0);
+    PosixError::ASSERT(r!=-1,"io_uring_register(IORING_UNREGISTER_BUFFERS)");
+}
+
+void IoRing::prepRead(const File& file, void* buf, size_t len, off_t offset, uint64_t userData)
+{
+    prep(IORING_OP_READ,file.fd(),uint64_t(buf),len,offset,userData);
+}
+
+void IoRing::prepRead(FixedFile file, void* buf, size_t len, off_t offset, uint64_t userData)
+{
+    prep(IORING_OP_READ,file.index,uint64_t(buf),len,offset,userData,true);
+}
+
+void IoRing::prepWrite(const File& file, const void* buf, size_t len, off_t offset, uint64_t userData)
+{
+    prep(IORING_OP_WRITE,file.fd(),uint64_t(buf),len,offset,userData);
+}
+
+void IoRing::prepWrite(FixedFile file, const void* buf, size_t len, off_t offset, uint64_t userData)
+{
+    prep(IORING_OP_WRITE,file.index,uint64_t(buf),len,offset,userData,true);
+}
+
+void IoRing::prepReadFixed(const File& file, void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_READ_FIXED,file.fd(),uint64_t(buf),len,offset,userData);
+    sqe->buf_index = bufIndex;
+}
+
+void IoRing::prepReadFixed(FixedFile file, void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_READ_FIXED,file.index,uint64_t(buf),len,offset,userData,true);
+    sqe->buf_index = bufIndex;
+}
+
+void IoRing::prepWriteFixed(const File& file, const void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_WRITE_FIXED,file.fd(),uint64_t(buf),len,offset,userData);
+    sqe->buf_index = bufIndex;
+}
+
+void IoRing::prepWriteFixed(FixedFile file, const void* buf, size_t len, off_t offset, unsigned bufIndex,
+                            uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_WRITE_FIXED,file.index,uint64_t(buf),len,offset,userData,true);
+    sqe->buf_index = bufIndex;
+}
+
+void IoRing::prepSend(const Socket& sock, const void* buf, size_t len, int flags, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_SEND,sock.fd(),uint64_t(buf),len,0,userData);
+    sqe->msg_flags = flags;
+}
+
+void IoRing::prepRecv(const Socket& sock, void* buf, size_t len, int flags, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_RECV,sock.fd(),uint64_t(buf),len,0,userData);
+    sqe->msg_flags = flags;
+}
+
+void IoRing::prepSendmsg(const Socket& sock, const msghdr* msg, int flags, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_SENDMSG,sock.fd(),uint64_t(msg),1,0,userData);
+    sqe->msg_flags = flags;
+}
+
+void IoRing::prepRecvmsg(const Socket& sock, msghdr* msg, int flags, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_RECVMSG,sock.fd(),uint64_t(msg),1,0,userData);
+    sqe->msg_flags = flags;
+}
+
+void IoRing::prepAccept(const Socket& sock, sockaddr* addr, socklen_t* addrlen, int flags, uint64_t userData)
+{
+    // addrlen goes in the offset field (addr2)
+    auto sqe = prep(IORING_OP_ACCEPT,sock.fd(),uint64_t(addr),0,uint64_t(addrlen),userData);
+    sqe->accept_flags = flags;
+}
+
+void IoRing::prepFsync(const File& file, bool dataOnly, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_FSYNC,file.fd(),0,0,0,userData);
+    sqe->fsync_flags = dataOnly ? IORING_FSYNC_DATASYNC : 0;
+}
+
+void IoRing::prepFsync(FixedFile file, bool dataOnly, uint64_t userData)
+{
+    auto sqe = prep(IORING_OP_FSYNC,file.index,0,0,0,userData,true);
+    sqe->fsync_flags = dataOnly ? IORING_FSYNC_DATASYNC : 0;
+}
+
+void IoRing::prepClose(File& file, uint64_t userData)
+{
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = file.release();
+    sqe->user_data = userData;
+}
+
+void IoRing::prepStatx(const File& dir, const char* path, int flags, unsigned mask, struct statx* out, uint64_t userData)
+{
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = dir.fd();
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->len = mask;
+    sqe->off = reinterpret_cast<uint64_t>(out);
+    sqe->statx_flags = flags;
+    sqe->user_data = userData;
+}
+
+unsigned IoRing::submit()
+{
+    return submitAndWait(0);
+}
+
+unsigned IoRing::submitAndWait(unsigned waitNr)
+{
+    __atomic_store_n(m_sqTail,m_sqLocalTail,__ATOMIC_RELEASE);
+    if (m_pending == 0 and waitNr == 0)
+    {
+        return 0;
+    }
+    unsigned flags = (waitNr > 0) ? IORING_ENTER_GETEVENTS : 0;
+    int r = enter(m_pending,waitNr,flags);
+    m_pending -= r;
+    return r;
+}
+
+unsigned IoRing::reap(IoCompletion* out, unsigned max)
+{
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail,__ATOMIC_ACQUIRE);
+    unsigned n = 0;
+    while (head != tail and n < max)
+    {
+        const io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+        out[n++] = IoCompletion{cqe.user_data,cqe.res,cqe.flags};
+        head++;
+    }
+    __atomic_store_n(m_cqHead,head,__ATOMIC_RELEASE);
+    return n;
+}
+
+IoCompletion IoRing::wait()
+{
+    IoCompletion ret;
+    while (reap(&ret,1) == 0)
+    {
+        submitAndWait(1);
+    }
+    return ret;
+}
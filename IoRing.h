@@ -0,0 +1,165 @@
+#ifndef IORING_H
+#define IORING_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "File.h"
+#include "Socket.h"
+
+namespace posixcpp
+{
+
+/// One reaped completion. res is the syscall return value, or -errno on failure
+struct IoCompletion
+{
+    uint64_t userData;
+    int32_t res;
+    uint32_t flags;
+};
+
+/// Index into the files given to IoRing::registerFiles(), for ops on a registered file
+struct FixedFile
+{
+    unsigned index;
+};
+
+/*
+** Wrapper for an io_uring(7) instance, driven directly with the raw syscalls.
+** Operations are queued with the prepXyz() methods, handed to the kernel in
+** batches with submit() and their results collected with reap().
+**
+** Buffers passed to prepXyz() must stay valid until the matching completion
+** has been reaped. The object is not thread safe, use one ring per thread.
+** Throws PosixError on setup/submit errors. Per-operation errors are reported
+** in IoCompletion::res.
+*/
+class IoRing
+{
+protected:
+    File m_ring;
+    io_uring_params m_params;
+
+    // Ring mappings, owned by the shared pointers
+    std::shared_ptr<char> m_sqMap;
+    std::shared_ptr<char> m_cqMap;
+    std::shared_ptr<io_uring_sqe> m_sqes;
+
+    // Pointers into the shared rings
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+
+    // Local copy of the sq tail, published to the kernel in submit()
+    unsigned m_sqLocalTail;
+
+    // Number of sqes queued but not yet submitted
+    unsigned m_pending;
+
+    io_uring_sqe* getSqe();
+    // fd is a registered file index if fixedFile
+    io_uring_sqe* prep(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t offset, uint64_t userData,
+                       bool fixedFile=false);
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+public:
+    /// Calls io_uring_setup(2). flags are the IORING_SETUP_xxx flags
+    IoRing(unsigned entries=128, unsigned flags=0);
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    /// Returns the io_uring file descriptor
+    int fd() const {return m_ring.fd();};
+
+    /// Number of submission queue entries
+    unsigned sqEntries() const {return m_params.sq_entries;};
+
+    /// Number of completion queue entries
+    unsigned cqEntries() const {return m_params.cq_entries;};
+
+    /// Number of operations queued but not yet submitted
+    unsigned pending() const {return m_pending;};
+
+    /*
+    ** Register fds with the ring. Ops use a registered file (IOSQE_FIXED_FILE)
+    ** only when passed FixedFile{i}, i being the position in fds. Ops on a
+    ** File always use its own fd, even if that fd was registered, so a closed
+    ** and reused fd number never reaches the old registered file.
+    */
+    void registerFiles(const std::vector<int>& fds);
+
+    void unregisterFiles();
+
+    /// Register buffers with the ring, for use with prepReadFixed()/prepWriteFixed()
+    void registerBuffers(const std::vector<iovec>& buffers);
+
+    void unregisterBuffers();
+
+    /// Queue a read(2) at offset. Use offset=-1 for the current file position
+    void prepRead(const File& file, void* buf, size_t len, off_t offset, uint64_t userData=0);
+    void prepRead(FixedFile file, void* buf, size_t len, off_t offset, uint64_t userData=0);
+
+    /// Queue a write(2) at offset. Use offset=-1 for the current file position
+    void prepWrite(const File& file, const void* buf, size_t len, off_t offset, uint64_t userData=0);
+    void prepWrite(FixedFile file, const void* buf, size_t len, off_t offset, uint64_t userData=0);
+
+    /// Queue a read into registered buffer bufIndex. buf must lie within that buffer
+    void prepReadFixed(const File& file, void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData=0);
+    void prepReadFixed(FixedFile file, void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData=0);
+
+    /// Queue a write from registered buffer bufIndex. buf must lie within that buffer
+    void prepWriteFixed(const File& file, const void* buf, size_t len, off_t offset, unsigned bufIndex, uint64_t userData=0);
+    void prepWriteFixed(FixedFile file, const void* buf, size_t len, off_t offset, unsigned bufIndex,
+                        uint64_t userData=0);
+
+    /// Queue a send(2)
+    void prepSend(const Socket& sock, const void* buf, size_t len, int flags=0, uint64_t userData=0);
+
+    /// Queue a recv(2)
+    void prepRecv(const Socket& sock, void* buf, size_t len, int flags=0, uint64_t userData=0);
+
+    /// Queue a sendmsg(2)
+    void prepSendmsg(const Socket& sock, const msghdr* msg, int flags=0, uint64_t userData=0);
+
+    /// Queue a recvmsg(2)
+    void prepRecvmsg(const Socket& sock, msghdr* msg, int flags=0, uint64_t userData=0);
+
+    /// Queue an accept4(2). The completion res is the new fd
+    void prepAccept(const Socket& sock, sockaddr* addr=nullptr, socklen_t* addrlen=nullptr, int flags=0, uint64_t userData=0);
+
+    /// Queue an fsync(2), or fdatasync(2) if dataOnly is true
+    void prepFsync(const File& file, bool dataOnly=false, uint64_t userData=0);
+    void prepFsync(FixedFile file, bool dataOnly=false, uint64_t userData=0);
+
+    /// Queue a close(2). The File gives up ownership of its fd
+    void prepClose(File& file, uint64_t userData=0);
+
+    /// Queue a statx(2) of path relative to dir, see File::statx(). path and out must stay valid until reaped
+    void prepStatx(const File& dir, const char* path, int flags, unsigned mask, struct statx* out, uint64_t userData=0);
+
+    /// Submit all queued operations without waiting. Returns the number submitted
+    unsigned submit();
+
+    /// Submit all queued operations and wait for at least waitNr completions
+    unsigned submitAndWait(unsigned waitNr);
+
+    /// Copy up to max completions into out without entering the kernel. Returns the number reaped
+    unsigned reap(IoCompletion* out, unsigned max);
+
+    /// Submit and block until one completion is available, then return it
+    IoCompletion wait();
+};
+
+}
+
+#endif
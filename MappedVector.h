@@ -0,0 +1,225 @@
+#ifndef MAPPEDVECTOR_H
+#define MAPPEDVECTOR_H
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "File.h"
+#include "MemMap.h"
+#include "PosixError.h"
+
+namespace posixcpp
+{
+
+/*
+** A std::vector-like container whose storage is a memory mapped file.
+** Sizes and capacities are in units of Typ. The file starts with a small header
+** holding the element count, so reopening the same path gives back the contents.
+** Growth is geometric, using ftruncate(2) and mremap(2) with MREMAP_MAYMOVE, so
+** pointers and references are invalidated by growth just as with std::vector.
+** Typ must be trivially copyable since its bytes are stored as-is.
+*/
+template <typename Typ>
+class MappedVector
+{
+    static_assert(std::is_trivially_copyable<Typ>::value,"MappedVector needs a trivially copyable type");
+
+protected:
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t elemSize;
+        uint64_t size;
+    };
+
+    static const uint64_t MAGIC = 0x726f7463655670ULL; // "pVector"
+    static const size_t HEADER_BYTES = 64;
+    static_assert(sizeof(Header) <= HEADER_BYTES and alignof(Typ) <= HEADER_BYTES,"header layout");
+
+    File m_file;
+    char* m_map;
+    size_t m_mapBytes;
+
+    Header* header() const {return reinterpret_cast<Header*>(m_map);};
+
+    static size_t bytesFor(size_t capacity) {return HEADER_BYTES+capacity*sizeof(Typ);};
+
+    // Resize the file and the mapping to hold capacity elements
+    void remap(size_t capacity)
+    {
+        size_t newBytes = bytesFor(capacity);
+        if (newBytes > m_mapBytes)
+        {
+            m_file.ftruncate(newBytes);
+        }
+        void* ptr = ::mremap(m_map,m_mapBytes,newBytes,MREMAP_MAYMOVE);
+        PosixError::ASSERT(ptr!=MAP_FAILED,"mremap");
+        if (newBytes < m_mapBytes)
+        {
+            m_file.ftruncate(newBytes);
+        }
+        m_map = static_cast<char*>(ptr);
+        m_mapBytes = newBytes;
+    };
+
+    void grow(size_t needed)
+    {
+        size_t cap = capacity();
+        reserve(std::max(needed,2*cap));
+    };
+
+public:
+    /// Opens (creating if needed) the backing file. Throws PosixError(EINVAL) if it holds a different type
+    MappedVector(const std::string& path, size_t initialCapacity=0)
+    : m_file(path,O_RDWR|O_CREAT,0644),
+      m_map(nullptr),
+      m_mapBytes(m_file.getSize(false))
+    {
+        bool created = (m_mapBytes == 0);
+        if (created)
+        {
+            m_mapBytes = bytesFor(std::max(initialCapacity,(getpagesize()-HEADER_BYTES)/sizeof(Typ)));
+            m_file.ftruncate(m_mapBytes);
+        }
+        else if (m_mapBytes < HEADER_BYTES)
+        {
+            throw PosixError("MappedVector file too small: "+path,EINVAL);
+        }
+        m_map = memMapCore<char>(m_file,m_mapBytes);
+        if (created)
+        {
+            *header() = Header{MAGIC,sizeof(Typ),0};
+        }
+        else if (header()->magic != MAGIC or header()->elemSize != sizeof(Typ) or header()->size > capacity())
+        {
+            ::munmap(m_map,m_mapBytes);
+            throw PosixError("MappedVector file does not match: "+path,EINVAL);
+        }
+        if (initialCapacity > capacity())
+        {
+            try
+            {
+                reserve(initialCapacity);
+            }
+            catch (...)
+            {
+                ::munmap(m_map,m_mapBytes);
+                throw;
+            }
+        }
+    };
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    /// Unmaps. The contents stay in the file, call sync() first for durability
+    ~MappedVector()
+    {
+        if (m_map != nullptr)
+        {
+            ::munmap(m_map,m_mapBytes);
+        }
+    };
+
+    File& file() {return m_file;};
+
+    size_t size() const {return header()->size;};
+
+    bool empty() const {return size() == 0;};
+
+    size_t capacity() const {return (m_mapBytes-HEADER_BYTES)/sizeof(Typ);};
+
+    Typ* data() const {return reinterpret_cast<Typ*>(m_map+HEADER_BYTES);};
+
+    Typ* begin() const {return data();};
+
+    Typ* end() const {return data()+size();};
+
+    Typ& operator[](size_t i) const {return data()[i];};
+
+    Typ& back() const {return data()[size()-1];};
+
+    /// Make room for at least capacity elements
+    void reserve(size_t capacity)
+    {
+        if (capacity > this->capacity())
+        {
+            remap(capacity);
+        }
+    };
+
+    /// Release unused capacity back to the file system
+    void shrink_to_fit()
+    {
+        if (capacity() > size())
+        {
+            remap(size());
+        }
+    };
+
+    void push_back(const Typ& value)
+    {
+        emplace_back(value);
+    };
+
+    template <typename... Args>
+    Typ& emplace_back(Args&&... args)
+    {
+        size_t n = size();
+        if (n == capacity())
+        {
+            // The arguments may refer into the mapping that grow() moves, as in v.push_back(v[0])
+            Typ value(std::forward<Args>(args)...);
+            grow(n+1);
+            Typ* ptr = new (data()+n) Typ(value);
+            header()->size = n+1;
+            return *ptr;
+        }
+        Typ* ptr = new (data()+n) Typ(std::forward<Args>(args)...);
+        header()->size = n+1;
+        return *ptr;
+    };
+
+    void pop_back()
+    {
+        header()->size--;
+    };
+
+    /// Resize to count elements. New elements are value-initialized
+    void resize(size_t count)
+    {
+        size_t n = size();
+        reserve(count);
+        if (count > n)
+        {
+            memset(static_cast<void*>(data()+n),0,(count-n)*sizeof(Typ));
+            for (size_t i=n; i<count; i++)
+            {
+                new (data()+i) Typ();
+            }
+        }
+        header()->size = count;
+    };
+
+    void clear()
+    {
+        header()->size = 0;
+    };
+
+    /// Wrapper for msync(2), flushes the contents and the element count to the file
+    void sync() const
+    {
+        int r = ::msync(m_map,m_mapBytes,MS_SYNC);
+        PosixError::ASSERT(r==0,"msync");
+    };
+};
+
+}
+
+#endif
@@ -1,8 +1,12 @@
 #include "File.h"
 #include "MemMap.h"
+#include "Metrics.h"
 #include <sys/mman.h>
+#include <linux/mman.h>
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 using namespace posixcpp;
 
@@ -15,3 +19,164 @@ map(File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapPr
     return std::shared_ptr<void>(ptr,deleter);
 }
 
+
+namespace
+{
+
+const size_t c_hugePage2MB = size_t(1)<<21;
+const size_t c_hugePage1GB = size_t(1)<<30;
+
+// True unless transparent huge pages are switched off system wide
+bool transparentHugePagesEnabled()
+{
+    static const bool enabled = []() {
+        try
+        {
+            File sysfs("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::string mode;
+            sysfs.read(mode,64);
+            return mode.find("[never]") == std::string::npos;
+        }
+        catch (const PosixError& e)
+        {
+            return false;
+        }
+    }();
+    return enabled;
+}
+
+size_t roundUp(size_t size, size_t align)
+{
+    return (size+align-1)/align*align;
+}
+
+// Anonymous mapping aligned to align, by over-allocating and trimming both ends
+void* mapAlignedAnonymous(size_t size, size_t align, int flags, int prot)
+{
+    size_t reserve = size+align;
+    char* ptr = static_cast<char*>(mmap(0,reserve,prot,flags,-1,0));
+    if (ptr == MAP_FAILED)
+    {
+        return MAP_FAILED;
+    }
+    char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(ptr),align));
+    if (aligned > ptr)
+    {
+        munmap(ptr,aligned-ptr);
+    }
+    size_t tail = (ptr+reserve)-(aligned+size);
+    if (tail > 0)
+    {
+        munmap(aligned+size,tail);
+    }
+    return aligned;
+}
+
+}
+
+size_t posixcpp::pageSizeBytes(PageSize pageSize)
+{
+    switch (pageSize)
+    {
+    case PAGE_TRANSPARENT_HUGE:
+    case PAGE_HUGE_2MB:
+        return c_hugePage2MB;
+    case PAGE_HUGE_1GB:
+        return c_hugePage1GB;
+    default:
+        return getpagesize();
+    }
+}
+
+void* posixcpp::memMapPages(File& file, size_t size, size_t offset, MmapFlags flags, MmapProt prot,
+                            PageSize pageSize, size_t& mappedBytes, size_t& usedPageSize)
+{
+    bool anonymous = flags & MAP_ANONYMOUS;
+    int fd = anonymous ? -1 : file.fd();
+
+    if (pageSize == PAGE_HUGE_2MB or pageSize == PAGE_HUGE_1GB)
+    {
+        size_t hugeSize = pageSizeBytes(pageSize);
+        int hugeFlags = MAP_HUGETLB | ((pageSize == PAGE_HUGE_2MB) ? MAP_HUGE_2MB : MAP_HUGE_1GB);
+        size_t length = roundUp(size,hugeSize);
+        void* ptr = mmap(0,length,prot,flags|hugeFlags,fd,offset);
+        if (ptr != MAP_FAILED)
+        {
+            mappedBytes = length;
+            usedPageSize = hugeSize;
+            return ptr;
+        }
+        // No huge pages reserved, or the fd is not on hugetlbfs
+        pageSize = PAGE_TRANSPARENT_HUGE;
+    }
+
+    if (pageSize == PAGE_TRANSPARENT_HUGE and transparentHugePagesEnabled())
+    {
+        size_t length = roundUp(size,c_hugePage2MB);
+        void* ptr = anonymous ? mapAlignedAnonymous(length,c_hugePage2MB,flags,prot)
+                              : mmap(0,length,prot,flags,fd,offset);
+        PosixError::ASSERT(ptr!=MAP_FAILED,"mmap");
+        mappedBytes = length;
+        usedPageSize = getpagesize();
+        // Only private anonymous memory is backed by THP under the default settings
+        bool privateAnon = anonymous and (flags & MAP_PRIVATE);
+        if (madvise(ptr,length,MADV_HUGEPAGE) == 0 and privateAnon)
+        {
+            usedPageSize = c_hugePage2MB;
+        }
+        return ptr;
+    }
+
+    mappedBytes = roundUp(size,getpagesize());
+    usedPageSize = getpagesize();
+    void* ptr = mmap(0,mappedBytes,prot,flags,fd,offset);
+    PosixError::ASSERT(ptr!=MAP_FAILED,"mmap");
+    return ptr;
+}
+
+void* posixcpp::memMapRaw(void* addr, size_t size, MmapProt prot, MmapFlags flags, int fd, size_t offset) noexcept
+{
+    POSIXCPP_METRIC_START();
+    void* ptr = mmap(addr,size,prot,flags,fd,offset);
+    POSIXCPP_METRIC_END(MMAP,ptr==MAP_FAILED ? -1 : ssize_t(size));
+    return ptr;
+}
+
+void posixcpp::memAdvise(void* addr, size_t len, MmapAdvice advice)
+{
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t aligned = start/getpagesize()*getpagesize();
+    int r = madvise(reinterpret_cast<void*>(aligned),len+(start-aligned),advice);
+    PosixError::ASSERT(r==0,"madvise");
+}
+
+void posixcpp::memPrefault(void* addr, size_t len, MmapProt prot, bool forWrite)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    forWrite = forWrite and (prot & PROT_WRITE);
+    int r = madvise(addr,len,forWrite ? MADV_POPULATE_WRITE : MADV_POPULATE_READ);
+    if (r == 0)
+    {
+        return;
+    }
+    PosixError::ASSERT(errno==EINVAL,"madvise(MADV_POPULATE)");
+
+    // Kernels before 5.14 - touch one byte per page
+    volatile char* ptr = static_cast<volatile char*>(addr);
+    size_t pageSize = getpagesize();
+    for (size_t off=0; off<len; off+=pageSize)
+    {
+        if (forWrite)
+        {
+            // Not ptr[off] = ptr[off], which could undo another process' store in between
+            __atomic_fetch_add(&ptr[off],0,__ATOMIC_RELAXED);
+        }
+        else
+        {
+            (void)ptr[off];
+        }
+    }
+}
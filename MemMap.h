@@ -13,24 +13,89 @@ enum MmapFlags {
     MAP_SHARED_=MAP_SHARED,
     MAP_PRIVATE_=MAP_PRIVATE,
     MAP_ANONYMOUS_=MAP_ANONYMOUS,
+    MAP_POPULATE_=MAP_POPULATE,
+    MAP_FIXED_=MAP_FIXED,
 };
 
+inline MmapFlags operator|(MmapFlags a, MmapFlags b)
+{
+    return MmapFlags(int(a)|int(b));
+}
+
 enum MmapProt {
+    PROT_NONE_=PROT_NONE,
     PROT_READ_=PROT_READ,
     PROT_WRITE_=PROT_WRITE,
     PROT_RW_=PROT_READ|PROT_WRITE,
 };
 
-// Generic mmap function returns a naked pointer
+// Access pattern advice for MemMap::advise(), ref. madvise(2)
+enum MmapAdvice {
+    MADV_NORMAL_=MADV_NORMAL,
+    MADV_SEQUENTIAL_=MADV_SEQUENTIAL,
+    MADV_RANDOM_=MADV_RANDOM,
+    MADV_WILLNEED_=MADV_WILLNEED,
+    MADV_DONTNEED_=MADV_DONTNEED,
+    MADV_FREE_=MADV_FREE,
+};
+
+// Wrapper for madvise(2). addr is rounded down to a page boundary
+void memAdvise(void* addr, size_t len, MmapAdvice advice);
+
+// Fault in [addr,addr+len) with MADV_POPULATE_READ/WRITE, touching each page on older kernels.
+// prot is the mapping's protection, forWrite is ignored without PROT_WRITE_ so a read-only
+// mapping is never written. The write touch is an atomic add of 0, so it cannot lose a
+// concurrent store to a shared mapping
+void memPrefault(void* addr, size_t len, MmapProt prot, bool forWrite);
+
+enum PageSize {
+    PAGE_DEFAULT,           // normal pages
+    PAGE_TRANSPARENT_HUGE,  // normal mapping with madvise(MADV_HUGEPAGE)
+    PAGE_HUGE_2MB,          // MAP_HUGETLB|MAP_HUGE_2MB
+    PAGE_HUGE_1GB,          // MAP_HUGETLB|MAP_HUGE_1GB
+};
+
+// Size in bytes of the given page size
+size_t pageSizeBytes(PageSize pageSize);
+
+/*
+** mmap with the requested page size. The length (and for anonymous mappings
+** the address) is rounded up to the huge page size. If huge pages are not
+** available falls back to PAGE_TRANSPARENT_HUGE, and from there to normal pages.
+** On return mappedBytes is the length actually mapped and usedPageSize the page
+** size in effect. Throws PosixError if even the normal mapping fails.
+*/
+void* memMapPages(File& file, size_t size, size_t offset, MmapFlags flags, MmapProt prot,
+                  PageSize pageSize, size_t& mappedBytes, size_t& usedPageSize);
+
+// mmap(2) with the MMAP metric recorded. Out of line so the inline templates below
+// are the same in every translation unit whether or not POSIXCPP_METRICS is defined
+void* memMapRaw(void* addr, size_t size, MmapProt prot, MmapFlags flags, int fd, size_t offset) noexcept;
+
+// Generic mmap function returns a naked pointer. addr is a hint, or the exact address with MAP_FIXED_
 template <typename Typ>
-Typ* memMapCore(posixcpp::File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapProt prot=PROT_RW_)
+Typ* memMapCore(posixcpp::File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapProt prot=PROT_RW_,
+                void* addr=nullptr)
 {
     // Note we do not keep a reference to file because we don't need to
-    void* ptr = mmap(0,size,prot,flags,file.fd(),offset);
+    void* ptr = memMapRaw(addr,size,prot,flags,file.fd(),offset);
     PosixError::ASSERT(ptr!=MAP_FAILED);
     return reinterpret_cast<Typ*>(ptr);
 }
 
+// memMapCore() that returns the errno in a Result instead of throwing
+template <typename Typ>
+Result<Typ*> tryMemMapCore(posixcpp::File& file, size_t size, size_t offset=0, MmapFlags flags=MAP_SHARED_,
+                           MmapProt prot=PROT_RW_, void* addr=nullptr) noexcept
+{
+    void* ptr = memMapRaw(addr,size,prot,flags,file.fd(),offset);
+    if (ptr == MAP_FAILED)
+    {
+        return Result<Typ*>::lastError();
+    }
+    return Result<Typ*>(reinterpret_cast<Typ*>(ptr));
+}
+
 // Generic mmap function returns a smart pointer
 template <typename Typ>
 std::shared_ptr<Typ> memMap(posixcpp::File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapProt prot=PROT_RW_)
@@ -42,20 +107,35 @@ std::shared_ptr<Typ> memMap(posixcpp::File& file, size_t size, size_t offset=0,M
 }
 
 /*
-** Note that regardless of the type, the size is always in bytes
-** TODO: should size be in units of Typ objects?
+** Note that regardless of the type, the size is always in bytes.
+** See MappedVector for a growable mapping sized in units of Typ.
 */
 template <typename Typ>
 class MemMap
 {
 protected:
     size_t m_sizeBytes;
+    size_t m_mappedBytes;
+    size_t m_pageSize;
+    MmapProt m_prot;
     std::shared_ptr<Typ> m_ptr;
 public:
-    MemMap(File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapProt prot=PROT_RW_)
+    MemMap(File& file, size_t size, size_t offset=0,MmapFlags flags=MAP_SHARED_, MmapProt prot=PROT_RW_,
+           PageSize pageSize=PAGE_DEFAULT)
     : m_sizeBytes(size),
-      m_ptr(memMap<Typ>(file,size,offset,flags,prot))
+      m_mappedBytes(size),
+      m_pageSize(getpagesize()),
+      m_prot(prot)
     {
+        if (pageSize == PAGE_DEFAULT)
+        {
+            m_ptr = memMap<Typ>(file,size,offset,flags,prot);
+            return;
+        }
+        void* ptr = memMapPages(file,size,offset,flags,prot,pageSize,m_mappedBytes,m_pageSize);
+        size_t mapped = m_mappedBytes;
+        auto deleter = [mapped](void* p) {munmap(p,mapped);};
+        m_ptr = std::shared_ptr<Typ>(reinterpret_cast<Typ*>(ptr),deleter);
     };
 
     size_t sizeBytes() const
@@ -68,15 +148,47 @@ public:
         return m_sizeBytes/sizeof(Typ);
     };
 
+    /// Length actually mapped, sizeBytes() rounded up to the page size
+    size_t mappedBytes() const
+    {
+        return m_mappedBytes;
+    };
+
+    /// Page size in effect for this mapping
+    size_t pageSize() const
+    {
+        return m_pageSize;
+    };
+
     size_t numPages() const
     {
-        return (sizeBytes()+getpagesize()-1)/getpagesize();
+        return (sizeBytes()+m_pageSize-1)/m_pageSize;
     }
 
     Typ* get() const
     {
         return m_ptr.get();
     };
+
+    /// Advise the kernel how [offset,offset+len) will be used. Bytes, len=0 means to the end. EINVAL past the end
+    void advise(MmapAdvice advice, size_t offset=0, size_t len=0) const
+    {
+        if (offset > m_sizeBytes or len > m_sizeBytes-offset)
+        {
+            throw PosixError("MemMap::advise",EINVAL);
+        }
+        if (len == 0)
+        {
+            len = m_sizeBytes-offset;
+        }
+        memAdvise(reinterpret_cast<char*>(get())+offset,len,advice);
+    };
+
+    /// Fault in the whole mapping now instead of on first access. Use MAP_POPULATE_ to do it in the constructor
+    void prefault(bool forWrite=false) const
+    {
+        memPrefault(get(),m_sizeBytes,m_prot,forWrite);
+    };
 };
 
 }
@@ -0,0 +1,277 @@
+#include <time.h>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include "Metrics.h"
+
+using namespace posixcpp;
+
+std::atomic<bool> Metrics::s_enabled(true);
+
+namespace
+{
+
+const char* c_names[Metrics::NUM_OPS] = {
+    "file_read",
+    "file_write",
+    "file_fsync",
+    "socket_send",
+    "socket_recv",
+    "mmap",
+};
+
+// One thread's counters. Only the owning thread writes, so relaxed load+store is enough
+struct Counter
+{
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t n)
+    {
+        value.store(value.load(std::memory_order_relaxed)+n,std::memory_order_relaxed);
+    };
+
+    uint64_t get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    };
+};
+
+struct OpCounters
+{
+    Counter calls;
+    Counter errors;
+    Counter bytes;
+    Counter totalNs;
+    Counter buckets[Metrics::NUM_BUCKETS];
+};
+
+struct ThreadMetrics
+{
+    OpCounters ops[Metrics::NUM_OPS];
+};
+
+void addTo(Metrics::OpStats& stats, const OpCounters& counters)
+{
+    stats.calls += counters.calls.get();
+    stats.errors += counters.errors.get();
+    stats.bytes += counters.bytes.get();
+    stats.totalNs += counters.totalNs.get();
+    for (unsigned i=0; i<Metrics::NUM_BUCKETS; i++)
+    {
+        stats.buckets[i] += counters.buckets[i].get();
+    }
+}
+
+// All live threads' counters, plus the totals of threads that have exited
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<ThreadMetrics*> threads;
+    Metrics::Snapshot retired;
+
+    Registry()
+    {
+        retired.ops.resize(Metrics::NUM_OPS);
+    };
+};
+
+Registry& registry()
+{
+    // Never destroyed, so threads exiting after main() can still retire
+    static Registry* reg = new Registry;
+    return *reg;
+}
+
+// Registers the calling thread on first use and retires it on exit
+struct ThreadSlot
+{
+    ThreadMetrics* metrics;
+
+    ThreadSlot()
+    : metrics(new ThreadMetrics)
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.push_back(metrics);
+    };
+
+    ~ThreadSlot()
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (unsigned op=0; op<Metrics::NUM_OPS; op++)
+        {
+            addTo(reg.retired.ops[op],metrics->ops[op]);
+        }
+        reg.threads.erase(std::find(reg.threads.begin(),reg.threads.end(),metrics));
+        delete metrics;
+    };
+};
+
+thread_local ThreadSlot t_slot;
+
+}
+
+unsigned Metrics::bucketIndex(uint64_t ns)
+{
+    if (ns < SUB_BUCKETS)
+    {
+        return ns;
+    }
+    unsigned e = 63-__builtin_clzll(ns);
+    if (e >= MAX_BITS)
+    {
+        return NUM_BUCKETS-1;
+    }
+    return (e-SUB_BITS+1)*SUB_BUCKETS+(ns>>(e-SUB_BITS))-SUB_BUCKETS;
+}
+
+uint64_t Metrics::bucketLowerBound(unsigned i)
+{
+    if (i < SUB_BUCKETS)
+    {
+        return i;
+    }
+    unsigned e = i/SUB_BUCKETS+SUB_BITS-1;
+    return uint64_t(SUB_BUCKETS+i%SUB_BUCKETS)<<(e-SUB_BITS);
+}
+
+uint64_t Metrics::OpStats::quantileNs(double q) const
+{
+    if (calls == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = std::max(uint64_t(1),uint64_t(q*calls+0.5));
+    uint64_t seen = 0;
+    for (unsigned i=0; i<NUM_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return (i+1 < NUM_BUCKETS) ? bucketLowerBound(i+1)-1 : bucketLowerBound(i);
+        }
+    }
+    return bucketLowerBound(NUM_BUCKETS-1);
+}
+
+const char* Metrics::name(Op op)
+{
+    return c_names[op];
+}
+
+void Metrics::enable(bool on)
+{
+    s_enabled.store(on,std::memory_order_relaxed);
+}
+
+bool Metrics::compiledIn()
+{
+#ifdef POSIXCPP_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t Metrics::nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return uint64_t(ts.tv_sec)*1000000000ULL+ts.tv_nsec;
+}
+
+void Metrics::recordNs(Op op, uint64_t ns, ssize_t result)
+{
+    OpCounters& counters = t_slot.metrics->ops[op];
+    counters.calls.add(1);
+    if (result < 0)
+    {
+        counters.errors.add(1);
+    }
+    else
+    {
+        counters.bytes.add(result);
+    }
+    counters.totalNs.add(ns);
+    counters.buckets[bucketIndex(ns)].add(1);
+}
+
+Metrics::Snapshot Metrics::snapshot()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    Snapshot snap = reg.retired;
+    for (unsigned op=0; op<NUM_OPS; op++)
+    {
+        snap.ops[op].name = c_names[op];
+        for (auto thread : reg.threads)
+        {
+            addTo(snap.ops[op],thread->ops[op]);
+        }
+    }
+    return snap;
+}
+
+std::string Metrics::Snapshot::toJson() const
+{
+    std::ostringstream oss;
+    oss << "{";
+    for (size_t i=0; i<ops.size(); i++)
+    {
+        const OpStats& op = ops[i];
+        oss << (i ? "," : "") << "\"" << op.name << "\":{"
+            << "\"calls\":" << op.calls
+            << ",\"errors\":" << op.errors
+            << ",\"bytes\":" << op.bytes
+            << ",\"total_ns\":" << op.totalNs
+            << ",\"p50_ns\":" << op.quantileNs(0.5)
+            << ",\"p90_ns\":" << op.quantileNs(0.9)
+            << ",\"p99_ns\":" << op.quantileNs(0.99)
+            << ",\"max_ns\":" << op.quantileNs(1.0)
+            << "}";
+    }
+    oss << "}";
+    return oss.str();
+}
+
+std::string Metrics::Snapshot::toPrometheus() const
+{
+    std::ostringstream oss;
+    const char* counters[][2] = {
+        {"posixcpp_calls_total","Calls to the wrapper"},
+        {"posixcpp_errors_total","Calls that returned an error"},
+        {"posixcpp_bytes_total","Bytes transferred"},
+    };
+    for (unsigned c=0; c<3; c++)
+    {
+        oss << "# HELP " << counters[c][0] << " " << counters[c][1] << "\n";
+        oss << "# TYPE " << counters[c][0] << " counter\n";
+        for (const OpStats& op : ops)
+        {
+            uint64_t value = (c == 0) ? op.calls : (c == 1) ? op.errors : op.bytes;
+            oss << counters[c][0] << "{op=\"" << op.name << "\"} " << value << "\n";
+        }
+    }
+
+    // Every bucket is listed so the series stay stable across scrapes, the counts are cumulative
+    const char* latency = "posixcpp_latency_seconds";
+    oss << "# HELP " << latency << " Time spent in the wrapper\n";
+    oss << "# TYPE " << latency << " histogram\n";
+    for (const OpStats& op : ops)
+    {
+        uint64_t cumulative = 0;
+        for (unsigned i=0; i+1<NUM_BUCKETS; i++)
+        {
+            cumulative += op.buckets[i];
+            char le[32];
+            snprintf(le,sizeof(le),"%g",bucketLowerBound(i+1)*1e-9);
+            oss << latency << "_bucket{op=\"" << op.name << "\",le=\"" << le << "\"} " << cumulative << "\n";
+        }
+        oss << latency << "_bucket{op=\"" << op.name << "\",le=\"+Inf\"} " << op.calls << "\n";
+        oss << latency << "_sum{op=\"" << op.name << "\"} " << op.totalNs*1e-9 << "\n";
+        oss << latency << "_count{op=\"" << op.name << "\"} " << op.calls << "\n";
+    }
+    return oss.str();
+}
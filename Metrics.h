@@ -0,0 +1,132 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <sys/types.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace posixcpp
+{
+
+/*
+** Call counts, bytes, errors and latency histograms for the syscall wrappers.
+**
+** The wrappers are only instrumented when the library is built with
+** POSIXCPP_METRICS defined (make metrics=1), otherwise the macros below
+** compile to nothing. memMapCore() is inline, so code calling it needs the
+** define as well. When built in, recording can be switched off at run time
+** with Metrics::enable(false), leaving one relaxed atomic load per call.
+**
+** Each thread records into its own counters without locks or atomic
+** read-modify-writes. snapshot() adds up all threads, including ones
+** that have exited.
+*/
+class Metrics
+{
+public:
+    enum Op {
+        FILE_READ,
+        FILE_WRITE,
+        FILE_FSYNC,
+        SOCKET_SEND,
+        SOCKET_RECV,
+        MMAP,
+        NUM_OPS
+    };
+
+    /*
+    ** Log-linear latency buckets in nanoseconds: values below 8 get a bucket
+    ** each, above that every power of two is split into 8 buckets, so a
+    ** bucket's width is at most 1/8 of its value. Values from 2^40 ns
+    ** (about 18 minutes) up go in the last bucket.
+    */
+    static const unsigned SUB_BITS = 3;
+    static const unsigned SUB_BUCKETS = 1<<SUB_BITS;
+    static const unsigned MAX_BITS = 40;
+    static const unsigned NUM_BUCKETS = (MAX_BITS-SUB_BITS+1)*SUB_BUCKETS;
+
+    /// Bucket holding the value ns
+    static unsigned bucketIndex(uint64_t ns);
+
+    /// Smallest value falling in bucket i
+    static uint64_t bucketLowerBound(unsigned i);
+
+    /// Totals for one Op
+    struct OpStats
+    {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t errors = 0;
+        uint64_t bytes = 0;
+        uint64_t totalNs = 0;
+        std::array<uint64_t,NUM_BUCKETS> buckets{};
+
+        /// Latency at quantile q (0..1), as the upper bound of its bucket. 0 if there were no calls
+        uint64_t quantileNs(double q) const;
+    };
+
+    struct Snapshot
+    {
+        std::vector<OpStats> ops; // indexed by Op
+
+        /// One object per op with counts and p50/p90/p99/max latencies
+        std::string toJson() const;
+
+        /// Prometheus text exposition format, with latency histograms in seconds
+        std::string toPrometheus() const;
+    };
+
+    /// Name of op as used in the exports, e.g. "file_read"
+    static const char* name(Op op);
+
+    /// Switch recording on or off at run time. On by default
+    static void enable(bool on);
+
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    };
+
+    /// True if the wrappers were built with POSIXCPP_METRICS
+    static bool compiledIn();
+
+    /// Current totals over all threads
+    static Snapshot snapshot();
+
+    /// Start timing a call. Returns 0 if recording is off
+    static uint64_t start()
+    {
+        return enabled() ? nowNs() : 0;
+    };
+
+    /// Record a call begun at start (from start()). result is the syscall's return: -1 is an error, else bytes
+    static void record(Op op, uint64_t start, ssize_t result)
+    {
+        if (start != 0)
+        {
+            recordNs(op,nowNs()-start,result);
+        }
+    };
+
+    static void recordNs(Op op, uint64_t ns, ssize_t result);
+
+protected:
+    static std::atomic<bool> s_enabled;
+
+    static uint64_t nowNs();
+};
+
+}
+
+#ifdef POSIXCPP_METRICS
+#define POSIXCPP_METRIC_START() uint64_t posixcppMetricStart = posixcpp::Metrics::start()
+#define POSIXCPP_METRIC_END(op,result) posixcpp::Metrics::record(posixcpp::Metrics::op,posixcppMetricStart,result)
+#else
+#define POSIXCPP_METRIC_START()
+#define POSIXCPP_METRIC_END(op,result)
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include "MemMap.h"
+#include "MirroredRingBuffer.h"
+#include "PosixError.h"
+
+using namespace posixcpp;
+
+MirroredRingBuffer::MirroredRingBuffer(size_t size)
+: m_memfd(File::memfd_create("MirroredRingBuffer")),
+  m_base(nullptr),
+  m_head(0),
+  m_tail(0)
+{
+    size_t page = getpagesize();
+    m_capacity = (std::max(size,size_t(1))+page-1)/page*page;
+    m_memfd.ftruncate(m_capacity);
+
+    // Reserve twice the address space, then map the memfd over each half
+    File anonymous;
+    m_base = memMapCore<char>(anonymous,2*m_capacity,0,MAP_PRIVATE_|MAP_ANONYMOUS_,PROT_NONE_);
+    try
+    {
+        memMapCore<char>(m_memfd,m_capacity,0,MAP_SHARED_|MAP_FIXED_,PROT_RW_,m_base);
+        memMapCore<char>(m_memfd,m_capacity,0,MAP_SHARED_|MAP_FIXED_,PROT_RW_,m_base+m_capacity);
+    }
+    catch (...)
+    {
+        ::munmap(m_base,2*m_capacity);
+        throw;
+    }
+}
+
+MirroredRingBuffer::~MirroredRingBuffer()
+{
+    ::munmap(m_base,2*m_capacity);
+}
+
+void MirroredRingBuffer::commit(size_t n)
+{
+    if (n > m_capacity-size())
+    {
+        throw PosixError("MirroredRingBuffer::commit past capacity",EINVAL);
+    }
+    m_head += n;
+}
+
+void MirroredRingBuffer::consume(size_t n)
+{
+    if (n > size())
+    {
+        throw PosixError("MirroredRingBuffer::consume past size",EINVAL);
+    }
+    m_tail += n;
+    if (m_tail >= m_capacity)
+    {
+        // Both views are the same pages, so shift back into the first one
+        m_tail -= m_capacity;
+        m_head -= m_capacity;
+    }
+}
+
+ssize_t MirroredRingBuffer::readFrom(const File& file)
+{
+    auto span = writable();
+    ssize_t n = valueOrWouldBlock(file.tryRead(span.data(),span.size()),"read");
+    if (n > 0)
+    {
+        m_head += n;
+    }
+    return n;
+}
+
+ssize_t MirroredRingBuffer::writeTo(const File& file)
+{
+    auto span = readable();
+    ssize_t n = valueOrWouldBlock(file.tryWrite(span.data(),span.size()),"write");
+    if (n > 0)
+    {
+        consume(n);
+    }
+    return n;
+}
+
+ssize_t MirroredRingBuffer::recvFrom(Socket& sock, int flags)
+{
+    auto span = writable();
+    ssize_t n = valueOrWouldBlock(sock.tryRecv(span.data(),span.size(),flags),"recv");
+    if (n > 0)
+    {
+        m_head += n;
+    }
+    return n;
+}
+
+ssize_t MirroredRingBuffer::sendTo(const Socket& sock, int flags)
+{
+    auto span = readable();
+    ssize_t n = valueOrWouldBlock(sock.trySend(span.data(),span.size(),flags),"send");
+    if (n > 0)
+    {
+        consume(n);
+    }
+    return n;
+}
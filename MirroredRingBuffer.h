@@ -0,0 +1,78 @@
+#ifndef MIRROREDRINGBUFFER_H
+#define MIRROREDRINGBUFFER_H
+
+#include <cstddef>
+#include <span>
+#include "File.h"
+#include "Socket.h"
+
+namespace posixcpp
+{
+
+/*
+** Ring buffer whose pages are mapped twice, back to back, from one memfd.
+** Byte i and byte i+capacity() are the same memory, so the readable and
+** writable regions are always contiguous and records never need to be
+** stitched together at the wrap point. Not thread safe.
+*/
+class MirroredRingBuffer
+{
+protected:
+    File m_memfd;
+    char* m_base;
+    size_t m_capacity;
+    size_t m_head; // write offset, m_tail <= m_head <= m_tail+m_capacity
+    size_t m_tail; // read offset, always < m_capacity
+
+public:
+    /// size is rounded up to a multiple of the page size
+    MirroredRingBuffer(size_t size);
+
+    MirroredRingBuffer(const MirroredRingBuffer&) = delete;
+    MirroredRingBuffer& operator=(const MirroredRingBuffer&) = delete;
+
+    ~MirroredRingBuffer();
+
+    size_t capacity() const {return m_capacity;};
+
+    /// Bytes waiting to be consumed
+    size_t size() const {return m_head-m_tail;};
+
+    bool empty() const {return m_head == m_tail;};
+
+    bool full() const {return size() == m_capacity;};
+
+    /// Free space, contiguous. Fill it then call commit()
+    std::span<char> writable() const
+    {
+        return std::span<char>(m_base+m_head,m_capacity-size());
+    };
+
+    /// Mark n bytes of writable() as filled
+    void commit(size_t n);
+
+    /// Data waiting to be consumed, contiguous. Use it then call consume()
+    std::span<const char> readable() const
+    {
+        return std::span<const char>(m_base+m_tail,size());
+    };
+
+    /// Mark n bytes of readable() as used
+    void consume(size_t n);
+
+    /// One read(2) into writable(). Returns the bytes read, 0 on end of file or if full(), -1 if it would block
+    ssize_t readFrom(const File& file);
+
+    /// One write(2) from readable(). Returns the bytes written, -1 if it would block
+    ssize_t writeTo(const File& file);
+
+    /// One recv(2) into writable(). Returns the bytes read, 0 on end of file or if full(), -1 if it would block
+    ssize_t recvFrom(Socket& sock, int flags=0);
+
+    /// One send(2) from readable(). Returns the bytes sent, -1 if it would block
+    ssize_t sendTo(const Socket& sock, int flags=0);
+};
+
+}
+
+#endif
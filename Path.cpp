@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstring>
+#include "Path.h"
+
+using namespace posixcpp;
+
+Path::Path() noexcept
+: m_size(0),
+  m_parentSize(0)
+{
+    m_inline[0] = '\0';
+}
+
+Path::Path(std::string_view path)
+: Path()
+{
+    if (path.empty())
+    {
+        return;
+    }
+    // The longest result is "./" followed by the whole input
+    allocate(path.size()+2);
+    char* out = data();
+    size_t n = 0;
+
+    // The first component decides the prefix
+    size_t end = std::min(path.find('/'),path.size());
+    std::string_view first = path.substr(0,end);
+    if (first.empty())
+    {
+        out[n++] = '/';
+    }
+    else if (first == ".")
+    {
+        out[n++] = '.';
+    }
+    else
+    {
+        out[n++] = '.';
+        out[n++] = '/';
+        memcpy(out+n,first.data(),first.size());
+        n += first.size();
+    }
+
+    // The rest are appended with single slashes, empty ones dropped
+    while (end < path.size())
+    {
+        size_t start = end+1;
+        end = std::min(path.find('/',start),path.size());
+        if (end == start)
+        {
+            continue;
+        }
+        if (out[n-1] != '/')
+        {
+            out[n++] = '/';
+        }
+        memcpy(out+n,path.data()+start,end-start);
+        n += end-start;
+    }
+    out[n] = '\0';
+    m_size = n;
+    findParent();
+}
+
+Path::Path(Normalized, std::string_view path)
+: Path()
+{
+    assign(path.data(),path.size());
+    findParent();
+}
+
+Path::Path(const Path& other)
+: Path()
+{
+    assign(other.c_str(),other.m_size);
+    m_parentSize = other.m_parentSize;
+}
+
+Path& Path::operator=(const Path& other)
+{
+    if (this != &other)
+    {
+        assign(other.c_str(),other.m_size);
+        m_parentSize = other.m_parentSize;
+    }
+    return *this;
+}
+
+Path::Path(Path&& other) noexcept
+: m_heap(std::move(other.m_heap)),
+  m_size(other.m_size),
+  m_parentSize(other.m_parentSize)
+{
+    if (not m_heap)
+    {
+        memcpy(m_inline,other.m_inline,m_size+1);
+    }
+    other.m_size = 0;
+    other.m_parentSize = 0;
+    other.m_inline[0] = '\0';
+}
+
+Path& Path::operator=(Path&& other) noexcept
+{
+    if (this != &other)
+    {
+        m_heap = std::move(other.m_heap);
+        m_size = other.m_size;
+        m_parentSize = other.m_parentSize;
+        if (not m_heap)
+        {
+            memcpy(m_inline,other.m_inline,m_size+1);
+        }
+        other.m_size = 0;
+        other.m_parentSize = 0;
+        other.m_inline[0] = '\0';
+    }
+    return *this;
+}
+
+void Path::allocate(size_t size)
+{
+    if (size < INLINE_SIZE)
+    {
+        m_heap.reset();
+    }
+    else
+    {
+        m_heap.reset(new char[size+1]);
+    }
+}
+
+void Path::assign(const char* str, size_t size)
+{
+    allocate(size);
+    char* out = data();
+    memcpy(out,str,size);
+    out[size] = '\0';
+    m_size = size;
+}
+
+void Path::findParent()
+{
+    size_t slash = view().rfind('/');
+    if (slash == std::string_view::npos)
+    {
+        m_parentSize = 0;
+    }
+    else
+    {
+        m_parentSize = (slash == 0) ? 1 : slash;
+    }
+}
+
+std::string_view Path::basename() const
+{
+    std::string_view path = view();
+    if (path == "/")
+    {
+        return std::string_view();
+    }
+    size_t slash = path.rfind('/');
+    return (slash == std::string_view::npos) ? path : path.substr(slash+1);
+}
+
+void Path::ComponentIterator::skip()
+{
+    while (not m_rest.empty() and m_rest.front() == '/')
+    {
+        m_rest.remove_prefix(1);
+    }
+    m_len = std::min(m_rest.find('/'),m_rest.size());
+}
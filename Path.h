@@ -0,0 +1,137 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace posixcpp
+{
+
+/*
+** A normalized path, see File::normalizePath() for the rules.
+** Normalizing is a single pass over the input. Paths up to INLINE_SIZE-1
+** bytes are stored in the object itself, so they make no allocation.
+** The parent's length is found once, so parent() does not parse again.
+** Components are returned as string_views into the path.
+*/
+class Path
+{
+public:
+    /// Paths shorter than this are stored without allocating
+    static const size_t INLINE_SIZE = 128;
+
+protected:
+    char m_inline[INLINE_SIZE];
+    std::unique_ptr<char[]> m_heap;
+    size_t m_size;
+    size_t m_parentSize; // 0 if there is no lexical parent
+
+    char* data() {return m_heap ? m_heap.get() : m_inline;};
+
+    // Make room for size bytes plus a terminator, dropping the contents
+    void allocate(size_t size);
+
+    void assign(const char* str, size_t size);
+
+    // An already normalized path, e.g. a parent
+    struct Normalized {};
+    Path(Normalized, std::string_view path);
+
+    void findParent();
+
+public:
+    Path() noexcept;
+
+    /// Normalize path
+    explicit Path(std::string_view path);
+
+    Path(const Path& other);
+    Path& operator=(const Path& other);
+
+    Path(Path&& other) noexcept;
+    Path& operator=(Path&& other) noexcept;
+
+    const char* c_str() const {return m_heap ? m_heap.get() : m_inline;};
+
+    std::string_view view() const {return std::string_view(c_str(),m_size);};
+
+    std::string str() const {return std::string(c_str(),m_size);};
+
+    size_t size() const {return m_size;};
+
+    bool empty() const {return m_size == 0;};
+
+    bool isAbsolute() const {return m_size > 0 and c_str()[0] == '/';};
+
+    bool operator==(std::string_view other) const {return view() == other;};
+
+    bool operator==(const Path& other) const {return view() == other.view();};
+
+    /// False for "" and "." whose parents cannot be found without the current directory
+    bool hasParent() const {return m_parentSize > 0;};
+
+    /// The path without its last component. "/" is its own parent. Empty if !hasParent()
+    std::string_view parentView() const {return std::string_view(c_str(),m_parentSize);};
+
+    Path parent() const {return Path(Normalized(),parentView());};
+
+    /// The last component, empty for "/"
+    std::string_view basename() const;
+
+    /// Iterates over the components: "./a/b" gives ".", "a", "b" and "/a/b" gives "a", "b"
+    class ComponentIterator
+    {
+        std::string_view m_rest; // from the current component on
+        size_t m_len;            // length of the current component
+
+        void skip();
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string_view* pointer;
+        typedef std::string_view reference;
+
+        ComponentIterator() : m_len(0) {};
+
+        explicit ComponentIterator(std::string_view path) : m_rest(path), m_len(0) {skip();};
+
+        std::string_view operator*() const {return m_rest.substr(0,m_len);};
+
+        ComponentIterator& operator++()
+        {
+            m_rest.remove_prefix(m_len);
+            skip();
+            return *this;
+        };
+
+        ComponentIterator operator++(int)
+        {
+            ComponentIterator ret = *this;
+            ++*this;
+            return ret;
+        };
+
+        bool operator==(const ComponentIterator& other) const
+        {
+            return m_rest.size() == other.m_rest.size();
+        };
+    };
+
+    struct Components
+    {
+        std::string_view path;
+        ComponentIterator begin() const {return ComponentIterator(path);};
+        ComponentIterator end() const {return ComponentIterator();};
+    };
+
+    Components components() const {return Components{view()};};
+};
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <unistd.h>
 #include <sys/file.h>
+#include <fcntl.h>
+#include <cerrno>
 
 #include "File.h"
 #include "PosixError.h"
@@ -24,3 +26,69 @@ Pipe::Pipe(int readFd, int writeFd)
     m_reader = File(readFd);
     m_writer = File(writeFd);
 }
+
+namespace
+{
+
+// Common call handling for the splice family: retry on EINTR, then see valueOrWouldBlock()
+template <typename Call>
+ssize_t spliceResult(Call call, const char* what)
+{
+    Result<ssize_t> r = call();
+    while (r.error().value() == EINTR)
+    {
+        r = call();
+    }
+    return valueOrWouldBlock(r,what);
+}
+
+}
+
+ssize_t Pipe::spliceFrom(int fd, size_t len, loff_t* offset, unsigned flags)
+{
+    return spliceResult([&]() {return trySpliceFrom(fd,len,offset,flags);},"splice");
+}
+
+ssize_t Pipe::spliceTo(int fd, size_t len, loff_t* offset, unsigned flags)
+{
+    return spliceResult([&]() {return trySpliceTo(fd,len,offset,flags);},"splice");
+}
+
+ssize_t Pipe::tee(Pipe& other, size_t len, unsigned flags)
+{
+    return spliceResult([&]() {return tryTee(other,len,flags);},"tee");
+}
+
+ssize_t Pipe::vmsplice(std::span<const iovec> iov, unsigned flags)
+{
+    return spliceResult([&]() {return syscallResult(::vmsplice(m_writer.fd(),iov.data(),iov.size(),flags));},"vmsplice");
+}
+
+Result<ssize_t> Pipe::trySpliceFrom(int fd, size_t len, loff_t* offset, unsigned flags) noexcept
+{
+    return syscallResult(::splice(fd,offset,m_writer.fd(),nullptr,len,flags));
+}
+
+Result<ssize_t> Pipe::trySpliceTo(int fd, size_t len, loff_t* offset, unsigned flags) noexcept
+{
+    return syscallResult(::splice(m_reader.fd(),nullptr,fd,offset,len,flags));
+}
+
+Result<ssize_t> Pipe::tryTee(Pipe& other, size_t len, unsigned flags) noexcept
+{
+    return syscallResult(::tee(m_reader.fd(),other.writer().fd(),len,flags));
+}
+
+int Pipe::setSize(int size)
+{
+    int r = ::fcntl(m_writer.fd(),F_SETPIPE_SZ,size);
+    PosixError::ASSERT(r!=-1,"fcntl(F_SETPIPE_SZ)");
+    return r;
+}
+
+int Pipe::size() const
+{
+    int r = ::fcntl(m_writer.fd(),F_GETPIPE_SZ);
+    PosixError::ASSERT(r!=-1,"fcntl(F_GETPIPE_SZ)");
+    return r;
+}
@@ -1,6 +1,8 @@
 #ifndef FOO_H
 #define FOO_H
 
+#include <fcntl.h>
+#include <span>
 #include "File.h"
 
 namespace posixcpp
@@ -29,6 +31,40 @@ public:
         return m_writer;
     };
 
+    /*
+    ** The splice family below moves data between the pipe and other fds
+    ** inside the kernel. They retry on EINTR, return -1 if the call would
+    ** block (EAGAIN) and throw PosixError on any other error.
+    */
+    /// Wrapper for splice(2) from fd into the pipe. A null offset uses fd's own offset
+    ssize_t spliceFrom(int fd, size_t len, loff_t* offset=nullptr, unsigned flags=SPLICE_F_MOVE|SPLICE_F_MORE);
+
+    /// Wrapper for splice(2) from the pipe to fd. A null offset uses fd's own offset
+    ssize_t spliceTo(int fd, size_t len, loff_t* offset=nullptr, unsigned flags=SPLICE_F_MOVE|SPLICE_F_MORE);
+
+    /// Wrapper for tee(2), duplicates up to len bytes into other without consuming them
+    ssize_t tee(Pipe& other, size_t len, unsigned flags=0);
+
+    /// Wrapper for vmsplice(2), maps user memory into the pipe
+    ssize_t vmsplice(std::span<const iovec> iov, unsigned flags=0);
+
+    /// noexcept spliceFrom(), returning EAGAIN and other errors in the Result
+    Result<ssize_t> trySpliceFrom(int fd, size_t len, loff_t* offset=nullptr,
+                                  unsigned flags=SPLICE_F_MOVE|SPLICE_F_MORE) noexcept;
+
+    /// noexcept spliceTo()
+    Result<ssize_t> trySpliceTo(int fd, size_t len, loff_t* offset=nullptr,
+                                unsigned flags=SPLICE_F_MOVE|SPLICE_F_MORE) noexcept;
+
+    /// noexcept tee()
+    Result<ssize_t> tryTee(Pipe& other, size_t len, unsigned flags=0) noexcept;
+
+    /// Set the pipe capacity with F_SETPIPE_SZ. Returns the capacity actually set
+    int setSize(int size);
+
+    /// Return the pipe capacity (F_GETPIPE_SZ)
+    int size() const;
+
     Pipe(Pipe&& other) noexcept    // move
     {
         m_reader = std::move(other.m_reader);
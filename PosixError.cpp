@@ -1,36 +1,51 @@
+#include <cerrno>
 #include <cstring>
 #include <array>
-#include <sstream>
 #include "PosixError.h"
 
 using namespace posixcpp;
 
 PosixError::PosixError(const std::string& msg)
-: m_errno(errno)
+: m_msg(msg),
+  m_errno(errno)
 {
-    std::array<char,128> msgBuf;
-    const char*eMsg = strerror_r(m_errno,&msgBuf[0],msgBuf.size());
-    std::ostringstream oss;
-    oss << "POSIX error [errno=" << errno << "," << eMsg << "] " << msg;
-    m_msg = oss.str();
 }
 
 PosixError::PosixError(const std::string& msg, int err)
-: m_errno(err)
+: m_msg(msg),
+  m_errno(err)
 {
-    std::array<char,128> msgBuf;
-    const char*eMsg = strerror_r(m_errno,&msgBuf[0],msgBuf.size());
-    std::ostringstream oss;
-    oss << "POSIX error [errno=" << errno << "," << eMsg << "] " << msg;
-    m_msg = oss.str();
 }
 
-void PosixError::ASSERT(bool truth, const std::string& msg)
+PosixError::PosixError(const PosixError& other)
+: std::exception(other),
+  m_msg(other.m_msg),
+  m_errno(other.m_errno)
 {
-    if (truth)
+}
+
+void PosixError::format() const noexcept
+{
+    try
     {
-        return;
+        std::array<char,128> msgBuf;
+        const char* eMsg = strerror_r(m_errno,&msgBuf[0],msgBuf.size());
+        m_what = "POSIX error [errno="+std::to_string(m_errno)+","+eMsg+"] "+m_msg;
+    }
+    catch (...)
+    {
+        // Out of memory, what() falls back to the bare message
+        m_what.clear();
     }
-    throw PosixError(msg);
 }
 
+const char* PosixError::what() const noexcept
+{
+    std::call_once(m_formatted,[this]() {format();});
+    return m_what.empty() ? m_msg.c_str() : m_what.c_str();
+}
+
+void PosixError::fail(const char* msg)
+{
+    throw PosixError(msg);
+}
@@ -1,31 +1,74 @@
+#ifndef POSIXERROR_H
+#define POSIXERROR_H
+
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 
 namespace posixcpp
 {
 
+/*
+** An errno and a short message saying what failed. The text returned by
+** what(), with the strerror(3) description, is only formatted on the first
+** call to what(), so throwing and catching a PosixError that is never
+** printed costs no formatting. The formatting runs under std::call_once, so
+** threads sharing one exception_ptr may call what() at the same time.
+*/
 class PosixError : public std::exception
 {
 protected:
     std::string m_msg;
     const int m_errno;
+    mutable std::string m_what; // formatted by the first what()
+    mutable std::once_flag m_formatted;
+
+    void format() const noexcept;
+
+    // Throw PosixError(msg) with the current errno. Out of line and cold, off the callers' fast path
+    [[noreturn]] __attribute__((cold,noinline)) static void fail(const char* msg);
 
 public:
     PosixError(const std::string& msg);
 
     PosixError(const std::string& msg, int err);
 
+    /// Copies format their own text, std::once_flag cannot be copied
+    PosixError(const PosixError& other);
+
     int errnoVal() const noexcept
     {
         return m_errno;
     }
 
-    const char* what() const noexcept override
+    /// The errno as a std::error_code, as in Result
+    std::error_code code() const noexcept
+    {
+        return std::error_code(m_errno,std::generic_category());
+    }
+
+    /// The message as "POSIX error [errno=N,description] msg"
+    const char* what() const noexcept override;
+
+    /// Throw PosixError(msg) with the current errno unless truth. Inline, the success path is one branch
+    static void ASSERT(bool truth, const char* msg="")
     {
-        return m_msg.c_str();
-    };
+        if (__builtin_expect(not truth,0))
+        {
+            fail(msg);
+        }
+    }
 
-    static void ASSERT(bool truth, const std::string& msg="");
+    static void ASSERT(bool truth, const std::string& msg)
+    {
+        if (__builtin_expect(not truth,0))
+        {
+            fail(msg.c_str());
+        }
+    }
 };
 
 };
+
+#endif
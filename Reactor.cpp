@@ -0,0 +1,157 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <cstdint>
+#include "PosixError.h"
+#include "Reactor.h"
+
+using namespace posixcpp;
+
+Reactor::Reactor(unsigned maxEvents)
+: m_events(maxEvents),
+  m_stopped(false)
+{
+    int fd = ::epoll_create1(EPOLL_CLOEXEC);
+    PosixError::ASSERT(fd!=-1,"epoll_create1");
+    m_epoll = File(fd,"epoll");
+
+    fd = ::eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    PosixError::ASSERT(fd!=-1,"eventfd");
+    m_wakeup = File(fd,"eventfd");
+    ctl(EPOLL_CTL_ADD,m_wakeup.fd(),EPOLLIN);
+}
+
+void Reactor::ctl(int op, int fd, uint32_t events, uint32_t generation)
+{
+    epoll_event ev{};
+    ev.events = events|EPOLLET|EPOLLRDHUP;
+    ev.data.u64 = (uint64_t(generation) << 32) | uint32_t(fd);
+    int r = ::epoll_ctl(m_epoll.fd(),op,fd,&ev);
+    PosixError::ASSERT(r!=-1,"epoll_ctl");
+}
+
+void Reactor::add(int fd, uint32_t events, callback_t callback)
+{
+    if (fd < 0)
+    {
+        throw PosixError("Reactor::add",EBADF);
+    }
+    if (size_t(fd) >= m_handlers.size())
+    {
+        m_handlers.resize(fd+1);
+    }
+    Handler& handler = m_handlers[fd];
+    ctl(EPOLL_CTL_ADD,fd,events,handler.generation+1);
+    handler.generation++;
+    handler.callback = callback;
+    handler.events = events;
+    handler.active = true;
+}
+
+void Reactor::modify(int fd, uint32_t events)
+{
+    if (not watching(fd))
+    {
+        throw PosixError("Reactor::modify",ENOENT);
+    }
+    ctl(EPOLL_CTL_MOD,fd,events,m_handlers[fd].generation);
+    m_handlers[fd].events = events;
+}
+
+void Reactor::remove(int fd)
+{
+    if (not watching(fd))
+    {
+        return;
+    }
+    // The kernel drops closed fds on its own, so EBADF/ENOENT are not errors here
+    int r = ::epoll_ctl(m_epoll.fd(),EPOLL_CTL_DEL,fd,nullptr);
+    if (r == -1 and errno != EBADF and errno != ENOENT)
+    {
+        throw PosixError("epoll_ctl(EPOLL_CTL_DEL)");
+    }
+    m_handlers[fd].active = false;
+    m_handlers[fd].callback = nullptr;
+}
+
+unsigned Reactor::runOnce(int timeoutMs)
+{
+    int n = ::epoll_wait(m_epoll.fd(),&m_events[0],m_events.size(),timeoutMs);
+    if (n == -1 and errno == EINTR)
+    {
+        return 0;
+    }
+    PosixError::ASSERT(n!=-1,"epoll_wait");
+
+    unsigned dispatched = 0;
+    for (int i=0; i<n; i++)
+    {
+        int fd = int(uint32_t(m_events[i].data.u64));
+        uint32_t generation = uint32_t(m_events[i].data.u64 >> 32);
+        uint32_t events = m_events[i].events;
+        if (fd == m_wakeup.fd())
+        {
+            uint64_t val;
+            (void)::read(fd,&val,sizeof(val));
+            continue;
+        }
+        if (not watching(fd) or m_handlers[fd].generation != generation)
+        {
+            // Removed, or removed and added again, by an earlier callback in this batch
+            continue;
+        }
+
+        // Move the callback out so it survives a remove() or add() from inside itself
+        callback_t callback = std::move(m_handlers[fd].callback);
+        try
+        {
+            callback(fd,events);
+        }
+        catch (...)
+        {
+            restore(fd,generation,callback);
+            throw;
+        }
+        dispatched++;
+        restore(fd,generation,callback);
+    }
+    return dispatched;
+}
+
+void Reactor::restore(int fd, uint32_t generation, callback_t& callback)
+{
+    Handler& handler = m_handlers[fd];
+    if (handler.active and handler.generation == generation)
+    {
+        handler.callback = std::move(callback);
+    }
+}
+
+void Reactor::run(int cpu)
+{
+    if (cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu,&cpus);
+        int r = ::pthread_setaffinity_np(::pthread_self(),sizeof(cpus),&cpus);
+        if (r != 0)
+        {
+            throw PosixError("pthread_setaffinity_np",r);
+        }
+    }
+    while (not m_stopped.load(std::memory_order_acquire))
+    {
+        runOnce();
+    }
+    m_stopped.store(false,std::memory_order_release);
+}
+
+void Reactor::stop()
+{
+    m_stopped.store(true,std::memory_order_release);
+    uint64_t one = 1;
+    m_wakeup.write(&one,sizeof(one));
+}
@@ -0,0 +1,115 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <sys/epoll.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "File.h"
+#include "Socket.h"
+#include "Pipe.h"
+#include "SocketPair.h"
+
+namespace posixcpp
+{
+
+/*
+** Edge-triggered epoll(7) event loop.
+** Handlers are kept in a flat array indexed by fd. A Reactor is not thread
+** safe except for stop(), so run one instance per thread (or per core, see run()).
+** Because the loop is edge-triggered, callbacks must drain the fd (read until EAGAIN)
+** and the fds should be nonblocking.
+*/
+class Reactor
+{
+public:
+    enum Events {
+        READABLE=EPOLLIN,
+        WRITABLE=EPOLLOUT,
+        CLOSED=EPOLLRDHUP|EPOLLHUP|EPOLLERR,
+    };
+
+    /// Called with the fd and the ready events (a mask of Events)
+    typedef std::function<void(int fd, uint32_t events)> callback_t;
+
+protected:
+    struct Handler
+    {
+        callback_t callback;
+        uint32_t events = 0;
+        uint32_t generation = 0; // bumped by add(), carried in the epoll data
+        bool active = false;
+    };
+
+    File m_epoll;
+    File m_wakeup;
+    std::vector<Handler> m_handlers;
+    std::vector<epoll_event> m_events;
+    std::atomic<bool> m_stopped;
+
+    void ctl(int op, int fd, uint32_t events, uint32_t generation=0);
+
+    // Put back a callback moved out by runOnce() unless it was removed or replaced meanwhile
+    void restore(int fd, uint32_t generation, callback_t& callback);
+
+public:
+    /// maxEvents is the number of events fetched per epoll_wait(2)
+    Reactor(unsigned maxEvents=256);
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /// Returns the epoll file descriptor
+    int fd() const {return m_epoll.fd();};
+
+    /// Watch fd for events (a mask of Events). CLOSED is always reported
+    void add(int fd, uint32_t events, callback_t callback);
+
+    void add(const File& file, uint32_t events, callback_t callback)
+    {
+        add(file.fd(),events,callback);
+    };
+
+    void add(const Socket& sock, uint32_t events, callback_t callback)
+    {
+        add(sock.fd(),events,callback);
+    };
+
+    /// Watch the read end of the pipe. Use add(pipe.writer(),...) for the write end
+    void add(Pipe& pipe, uint32_t events, callback_t callback)
+    {
+        add(pipe.reader().fd(),events,callback);
+    };
+
+    /// Watch the reader() end of the pair. Use add(pair.writer(),...) for the other end
+    void add(SocketPair& pair, uint32_t events, callback_t callback)
+    {
+        add(pair.reader().fd(),events,callback);
+    };
+
+    /// Change the events watched on fd
+    void modify(int fd, uint32_t events);
+
+    /// Stop watching fd. Safe to call from a callback, including for the current fd
+    void remove(int fd);
+
+    /// Returns true if fd is being watched
+    bool watching(int fd) const
+    {
+        return fd >= 0 and size_t(fd) < m_handlers.size() and m_handlers[fd].active;
+    };
+
+    /// Wait up to timeoutMs (-1 = forever) and dispatch ready callbacks. Returns the number dispatched
+    unsigned runOnce(int timeoutMs=-1);
+
+    /// Dispatch until stop() is called. If cpu >= 0 the calling thread is pinned to that cpu first
+    void run(int cpu=-1);
+
+    /// Make run() return. Safe to call from any thread
+    void stop();
+};
+
+}
+
+#endif
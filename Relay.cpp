@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include "PosixError.h"
+#include "Relay.h"
+
+using namespace posixcpp;
+
+Relay::Relay(int srcFd, int dstFd, size_t pipeSize)
+: m_src(srcFd),
+  m_dst(dstFd),
+  m_buffered(0),
+  m_eof(false)
+{
+    try
+    {
+        m_pipe.setSize(std::min(pipeSize,size_t(INT_MAX)));
+    }
+    catch (const PosixError& e)
+    {
+        // Unprivileged users are capped by /proc/sys/fs/pipe-max-size
+        if (e.errnoVal() != EPERM)
+        {
+            throw;
+        }
+    }
+    m_pipeSize = m_pipe.size();
+}
+
+size_t Relay::drain()
+{
+    size_t moved = 0;
+    while (m_buffered > 0)
+    {
+        ssize_t out = m_pipe.spliceTo(m_dst,m_buffered);
+        if (out == -1)
+        {
+            break;
+        }
+        m_buffered -= out;
+        moved += out;
+    }
+    return moved;
+}
+
+size_t Relay::transfer(size_t len)
+{
+    // Leftovers from an earlier call go out before anything new is read
+    size_t moved = drain();
+    if (m_buffered > 0 or m_eof or moved >= len)
+    {
+        return moved;
+    }
+    ssize_t in = m_pipe.spliceFrom(m_src,std::min(len-moved,m_pipeSize));
+    if (in == -1)
+    {
+        return moved;
+    }
+    if (in == 0)
+    {
+        m_eof = true;
+        return moved;
+    }
+    m_buffered = in;
+    return moved + drain();
+}
+
+size_t Relay::run()
+{
+    size_t total = 0;
+    while (not m_eof or m_buffered > 0)
+    {
+        total += transfer(SIZE_MAX);
+    }
+    return total;
+}
@@ -0,0 +1,74 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <cstddef>
+#include "File.h"
+#include "Pipe.h"
+#include "Socket.h"
+
+namespace posixcpp
+{
+
+/*
+** Moves bytes from one fd to another entirely in kernel space, by splicing
+** through an internal Pipe. Works with blocking and nonblocking fds: data that
+** could not be delivered stays in the pipe and goes out first on the next call.
+*/
+class Relay
+{
+protected:
+    const int m_src;
+    const int m_dst;
+    Pipe m_pipe;
+    size_t m_pipeSize;
+    size_t m_buffered; // bytes sitting in m_pipe
+    bool m_eof;
+
+    // Deliver what is in the pipe. Returns the bytes delivered
+    size_t drain();
+
+public:
+    static const size_t DEFAULT_PIPE_SIZE = 1<<20;
+
+    /// The relay does not own the fds. pipeSize is a request, see pipeSize()
+    Relay(int srcFd, int dstFd, size_t pipeSize=DEFAULT_PIPE_SIZE);
+
+    Relay(const Socket& src, const Socket& dst, size_t pipeSize=DEFAULT_PIPE_SIZE)
+    : Relay(src.fd(),dst.fd(),pipeSize)
+    {
+    };
+
+    Relay(const Socket& src, const File& dst, size_t pipeSize=DEFAULT_PIPE_SIZE)
+    : Relay(src.fd(),dst.fd(),pipeSize)
+    {
+    };
+
+    Relay(const File& src, const Socket& dst, size_t pipeSize=DEFAULT_PIPE_SIZE)
+    : Relay(src.fd(),dst.fd(),pipeSize)
+    {
+    };
+
+    Relay(const File& src, const File& dst, size_t pipeSize=DEFAULT_PIPE_SIZE)
+    : Relay(src.fd(),dst.fd(),pipeSize)
+    {
+    };
+
+    /// One splice from the source of at most len bytes, then deliver it. Returns the bytes delivered
+    size_t transfer(size_t len);
+
+    /// Relay until the source reaches end of file. Meant for blocking fds. Returns the bytes delivered
+    size_t run();
+
+    /// True once the source has reported end of file
+    bool eof() const {return m_eof;};
+
+    /// Bytes read from the source but not yet delivered
+    size_t buffered() const {return m_buffered;};
+
+    /// Capacity of the internal pipe, which limits the size of each splice
+    size_t pipeSize() const {return m_pipeSize;};
+};
+
+}
+
+#endif
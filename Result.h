@@ -0,0 +1,100 @@
+#ifndef RESULT_H
+#define RESULT_H
+
+#include <sys/types.h>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+#include "PosixError.h"
+
+namespace posixcpp
+{
+
+/*
+** The value of a call or the errno it failed with, for the noexcept tryXyz()
+** variants of the wrappers. It follows std::expected (C++23): has_value(),
+** value(), error(), value_or() and operator*. The errors are in
+** std::generic_category(), so they compare equal to std::errc values.
+** value() on an error throws a PosixError with the same errno as the
+** throwing wrapper, but with "Result::value" as its message since the
+** Result does not carry the call name.
+** Typ must be default constructible.
+*/
+template <typename Typ>
+class Result
+{
+protected:
+    Typ m_value{};
+    std::error_code m_error;
+
+public:
+    Result(const Typ& value) noexcept : m_value(value) {};
+    Result(Typ&& value) noexcept : m_value(std::move(value)) {};
+    Result(std::error_code error) noexcept : m_error(error) {};
+
+    /// The current errno as an error
+    static Result lastError() noexcept
+    {
+        return Result(std::error_code(errno,std::generic_category()));
+    };
+
+    bool has_value() const noexcept {return not m_error;};
+    explicit operator bool() const noexcept {return has_value();};
+
+    std::error_code error() const noexcept {return m_error;};
+
+    /// True for EAGAIN (== EWOULDBLOCK), the normal outcome on a nonblocking fd
+    bool wouldBlock() const noexcept {return m_error.value() == EAGAIN;};
+
+    /// The value. Throws PosixError with the errno if there is none
+    const Typ& value() const&
+    {
+        if (m_error)
+        {
+            throw PosixError("Result::value",m_error.value());
+        }
+        return m_value;
+    };
+
+    Typ& value() &
+    {
+        if (m_error)
+        {
+            throw PosixError("Result::value",m_error.value());
+        }
+        return m_value;
+    };
+
+    Typ value_or(Typ other) const noexcept {return m_error ? other : m_value;};
+
+    /// The value without checking
+    const Typ& operator*() const noexcept {return m_value;};
+    Typ& operator*() noexcept {return m_value;};
+    const Typ* operator->() const noexcept {return &m_value;};
+    Typ* operator->() noexcept {return &m_value;};
+};
+
+/// The value of r, -1 if the call would block (EAGAIN). Throws PosixError(what) with the errno otherwise
+inline ssize_t valueOrWouldBlock(const Result<ssize_t>& r, const char* what)
+{
+    if (r.has_value())
+    {
+        return *r;
+    }
+    if (r.wouldBlock())
+    {
+        return -1;
+    }
+    throw PosixError(what,r.error().value());
+}
+
+/// Result of a syscall returning -1 with errno set on failure
+template <typename Typ>
+inline Result<Typ> syscallResult(Typ r) noexcept
+{
+    return (r == -1) ? Result<Typ>::lastError() : Result<Typ>(r);
+}
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "PosixError.h"
+#include "ScmRights.h"
+
+using namespace posixcpp;
+
+size_t posixcpp::sendFds(int sockFd, std::span<const int> fds)
+{
+    std::vector<char> control(CMSG_SPACE(std::min(fds.size(),SCM_MAX_FDS)*sizeof(int)));
+    size_t messages = 0;
+    while (not fds.empty())
+    {
+        size_t count = std::min(fds.size(),SCM_MAX_FDS);
+        // Stream sockets need at least one byte of data to carry the ancillary data
+        char byte = 0;
+        iovec iov{&byte,1};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = &control[0];
+        msg.msg_controllen = CMSG_SPACE(count*sizeof(int));
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(count*sizeof(int));
+        memcpy(CMSG_DATA(cmsg),fds.data(),count*sizeof(int));
+
+        ssize_t r = ::sendmsg(sockFd,&msg,MSG_NOSIGNAL);
+        PosixError::ASSERT(r!=-1,"sendmsg(SCM_RIGHTS)");
+        fds = fds.subspan(count);
+        messages++;
+    }
+    return messages;
+}
+
+size_t posixcpp::sendFds(int sockFd, std::span<const File> files)
+{
+    std::vector<int> fds(files.size());
+    std::transform(files.begin(),files.end(),fds.begin(),[](const File& f) {return f.fd();});
+    return sendFds(sockFd,std::span<const int>(fds));
+}
+
+std::vector<File> posixcpp::recvFds(int sockFd, size_t maxFds)
+{
+    std::vector<char> control(CMSG_SPACE(maxFds*sizeof(int)));
+    char byte;
+    iovec iov{&byte,1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = &control[0];
+    msg.msg_controllen = control.size();
+
+    ssize_t r = ::recvmsg(sockFd,&msg,MSG_CMSG_CLOEXEC);
+    PosixError::ASSERT(r!=-1,"recvmsg(SCM_RIGHTS)");
+    if (r == 0)
+    {
+        return std::vector<File>();
+    }
+
+    std::vector<File> files;
+    for (cmsghdr* cmsg=CMSG_FIRSTHDR(&msg); cmsg!=nullptr; cmsg=CMSG_NXTHDR(&msg,cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET or cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len-CMSG_LEN(0))/sizeof(int);
+        const unsigned char* data = CMSG_DATA(cmsg);
+        for (size_t i=0; i<count; i++)
+        {
+            int fd;
+            memcpy(&fd,data+i*sizeof(int),sizeof(int));
+            files.emplace_back(fd,"scm_rights");
+        }
+    }
+    if (msg.msg_flags & MSG_CTRUNC)
+    {
+        // The files received so far are closed when the vector goes away
+        throw PosixError("recvFds: more descriptors than maxFds",EMSGSIZE);
+    }
+    if (files.empty())
+    {
+        // Plain data, which would otherwise look like end of file to the caller
+        throw PosixError("recvFds: message without descriptors",EBADMSG);
+    }
+    return files;
+}
@@ -0,0 +1,37 @@
+#ifndef SCMRIGHTS_H
+#define SCMRIGHTS_H
+
+#include <span>
+#include <vector>
+#include "File.h"
+
+namespace posixcpp
+{
+
+/*
+** Passing file descriptors over AF_UNIX sockets with SCM_RIGHTS, ref. unix(7).
+** Each sendmsg(2) carries up to SCM_MAX_FDS descriptors plus one byte of data,
+** larger spans are split across several messages. The receiver gets new
+** descriptors (with O_CLOEXEC) referring to the same open files.
+*/
+
+/// The kernel's per-message limit (SCM_MAX_FD in the kernel sources)
+static const size_t SCM_MAX_FDS = 253;
+
+/// Send fds over the unix socket sockFd. Returns the number of messages sent
+size_t sendFds(int sockFd, std::span<const int> fds);
+
+/// Send the descriptors of files over the unix socket sockFd. Returns the number of messages sent
+size_t sendFds(int sockFd, std::span<const File> files);
+
+/*
+** Receive one message of descriptors from sockFd. Returns an empty vector
+** only at end of file. Throws PosixError(EMSGSIZE) if the message carried
+** more than maxFds descriptors, after closing the ones that did arrive, and
+** PosixError(EBADMSG) for a message with data but no descriptors.
+*/
+std::vector<File> recvFds(int sockFd, size_t maxFds=SCM_MAX_FDS);
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SHAREDFILE_H
+#define SHAREDFILE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include "File.h"
+
+namespace posixcpp
+{
+
+/*
+** Reference counted handle to one File. Copies share the same fd (no dup(2))
+** and moves are pointer swaps, so neither makes a syscall, and the cached
+** mode and fstat data are the File's own. The fd is closed when the last
+** handle goes away. Since the fd is shared so is its file offset.
+*/
+class SharedFile
+{
+protected:
+    std::shared_ptr<File> m_file;
+
+public:
+    /// An empty handle, fd() is -1
+    SharedFile() noexcept {};
+
+    /// Take over file
+    explicit SharedFile(File&& file)
+    : m_file(std::make_shared<File>(std::move(file)))
+    {
+    };
+
+    /// Open filename, as File(filename,posixFlags,perm)
+    explicit SharedFile(const std::string& filename, int posixFlags=O_RDONLY, int perm=File::PERM_GRWX)
+    : m_file(std::make_shared<File>(filename,posixFlags,perm))
+    {
+    };
+
+    int fd() const {return m_file ? m_file->fd() : -1;};
+
+    /// True unless empty or moved from
+    explicit operator bool() const {return bool(m_file);};
+
+    File& operator*() const {return *m_file;};
+
+    File* operator->() const {return m_file.get();};
+
+    /// Number of handles sharing the File
+    long use_count() const {return m_file.use_count();};
+};
+
+}
+
+#endif
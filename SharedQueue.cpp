@@ -0,0 +1,39 @@
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#include "PosixError.h"
+#include "SharedQueue.h"
+
+using namespace posixcpp;
+
+bool posixcpp::futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs)
+{
+    timespec ts;
+    timespec* timeout = nullptr;
+    if (timeoutMs >= 0)
+    {
+        ts.tv_sec = timeoutMs/1000;
+        ts.tv_nsec = (timeoutMs%1000)*1000000L;
+        timeout = &ts;
+    }
+    long r = ::syscall(SYS_futex,reinterpret_cast<uint32_t*>(word),FUTEX_WAIT,expected,timeout,nullptr,0);
+    if (r == -1)
+    {
+        if (errno == ETIMEDOUT)
+        {
+            return false;
+        }
+        // EAGAIN: the word had already changed, EINTR: treat as a spurious wakeup
+        PosixError::ASSERT(errno==EAGAIN or errno==EINTR,"futex(FUTEX_WAIT)");
+    }
+    return true;
+}
+
+int posixcpp::futexWake(std::atomic<uint32_t>* word, int count)
+{
+    long r = ::syscall(SYS_futex,reinterpret_cast<uint32_t*>(word),FUTEX_WAKE,count,nullptr,nullptr,0);
+    PosixError::ASSERT(r!=-1,"futex(FUTEX_WAKE)");
+    return int(r);
+}
@@ -0,0 +1,350 @@
+#ifndef SHAREDQUEUE_H
+#define SHAREDQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "File.h"
+#include "MemMap.h"
+#include "PosixError.h"
+
+namespace posixcpp
+{
+
+static const size_t CACHE_LINE = 64;
+
+/*
+** Wrappers for futex(2) on a word in shared memory. They do not use
+** FUTEX_PRIVATE_FLAG so waiters and wakers may be in different processes.
+*/
+/// Sleep while *word == expected. Returns false on timeout (timeoutMs=-1 waits forever)
+bool futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs=-1);
+
+/// Wake up to count waiters on word. Returns the number woken
+int futexWake(std::atomic<uint32_t>* word, int count=1);
+
+/*
+** Lets the single consumer of a queue sleep on a futex, and producers wake
+** it only when it is actually asleep, so the fast path makes no syscalls.
+*/
+struct alignas(CACHE_LINE) QueueWaker
+{
+    std::atomic<uint32_t> sleeping{0};
+
+    /// Called by producers after publishing an element
+    void wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) != 0 and sleeping.exchange(0) != 0)
+        {
+            futexWake(&sleeping,1);
+        }
+    };
+
+    /// Called by the consumer: spin on tryPop, then sleep until woken or timeoutMs passes
+    template <typename TryPop>
+    bool wait(TryPop&& tryPop, unsigned spins, int timeoutMs)
+    {
+        // Wakes for other elements or spurious ones sleep only for what is left
+        typedef std::chrono::steady_clock clock;
+        clock::time_point deadline = clock::now()+std::chrono::milliseconds(std::max(timeoutMs,0));
+        for (unsigned i=0; i<spins; i++)
+        {
+            if (tryPop())
+            {
+                return true;
+            }
+        }
+        while (true)
+        {
+            sleeping.store(1,std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tryPop())
+            {
+                sleeping.store(0,std::memory_order_relaxed);
+                return true;
+            }
+            int remainingMs = -1;
+            if (timeoutMs >= 0)
+            {
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline-clock::now()).count();
+                remainingMs = std::max<int>(left,0);
+            }
+            if (not futexWait(&sleeping,1,remainingMs))
+            {
+                sleeping.store(0,std::memory_order_relaxed);
+                return tryPop();
+            }
+            if (tryPop())
+            {
+                return true;
+            }
+        }
+    };
+};
+
+/*
+** Common layout of the shared queues: a control block followed by the slots,
+** all inside one MAP_SHARED mapping of a File (memfd_create, shm_open or a
+** regular file). The creator sizes and initializes the file; other processes
+** attach by mapping the same File, either inherited across fork(2) or passed
+** over a unix socket. Typ must be trivially copyable.
+*/
+template <typename Typ, typename Slot>
+class SharedQueueBase
+{
+    static_assert(std::is_trivially_copyable<Typ>::value,"shared queues need a trivially copyable type");
+
+protected:
+    static const uint64_t MAGIC = 0x65756575516d6873ULL; // "shmQueue", little endian
+
+    struct Control
+    {
+        alignas(CACHE_LINE) std::atomic<uint64_t> head; // next slot to write, owned by producers
+        alignas(CACHE_LINE) std::atomic<uint64_t> tail; // next slot to read, owned by the consumer
+        QueueWaker waker;
+        alignas(CACHE_LINE) uint64_t magic;
+        uint64_t capacity;
+        uint64_t slotSize;
+    };
+
+    MemMap<char> m_map;
+    Control* m_ctl;
+    Slot* m_slots;
+    uint64_t m_mask;
+
+    static size_t roundCapacity(size_t capacity)
+    {
+        size_t cap = 1;
+        while (cap < capacity)
+        {
+            cap <<= 1;
+        }
+        return cap;
+    };
+
+    // Size the file for a new queue, returns the bytes to map
+    static size_t create(File& file, size_t capacity)
+    {
+        size_t bytes = bytesFor(capacity);
+        file.ftruncate(bytes);
+        return bytes;
+    };
+
+    // Size of an existing queue's file
+    static size_t attach(File& file)
+    {
+        size_t bytes = file.getSize(false);
+        if (bytes < sizeof(Control))
+        {
+            throw PosixError("shared queue file too small",EINVAL);
+        }
+        return bytes;
+    };
+
+    // Create a new queue in file
+    SharedQueueBase(File& file, size_t capacity)
+    : m_map(file,create(file,capacity)),
+      m_ctl(new (m_map.get()) Control),
+      m_slots(reinterpret_cast<Slot*>(m_map.get()+sizeof(Control))),
+      m_mask(roundCapacity(capacity)-1)
+    {
+        m_ctl->head.store(0,std::memory_order_relaxed);
+        m_ctl->tail.store(0,std::memory_order_relaxed);
+        m_ctl->magic = MAGIC;
+        m_ctl->capacity = m_mask+1;
+        m_ctl->slotSize = sizeof(Slot);
+    };
+
+    // Attach to a queue created by another process
+    SharedQueueBase(File& file)
+    : m_map(file,attach(file)),
+      m_ctl(reinterpret_cast<Control*>(m_map.get())),
+      m_slots(reinterpret_cast<Slot*>(m_map.get()+sizeof(Control))),
+      m_mask(m_ctl->capacity-1)
+    {
+        if (m_ctl->magic != MAGIC or m_ctl->slotSize != sizeof(Slot) or
+            m_map.sizeBytes() < bytesFor(m_ctl->capacity))
+        {
+            throw PosixError("shared queue file does not match",EINVAL);
+        }
+    };
+
+public:
+    /// Bytes of shared memory needed for capacity elements (rounded up to a power of two)
+    static size_t bytesFor(size_t capacity)
+    {
+        return sizeof(Control)+roundCapacity(capacity)*sizeof(Slot);
+    };
+
+    size_t capacity() const {return m_mask+1;};
+
+    /// Elements in the queue. Only a snapshot while other processes are using it
+    size_t size() const
+    {
+        return m_ctl->head.load(std::memory_order_acquire)-m_ctl->tail.load(std::memory_order_acquire);
+    };
+
+    bool empty() const {return size() == 0;};
+};
+
+/*
+** Wait-free single producer, single consumer ring.
+** push() and pop() never make syscalls, except push() waking a consumer
+** sleeping in popWait().
+*/
+template <typename Typ>
+class SpscQueue : public SharedQueueBase<Typ,Typ>
+{
+    typedef SharedQueueBase<Typ,Typ> Base;
+    using Base::m_ctl;
+    using Base::m_slots;
+    using Base::m_mask;
+
+    // Each side's stale view of the other side's index, to avoid sharing the cache line
+    uint64_t m_cachedTail = 0;
+    uint64_t m_cachedHead = 0;
+
+public:
+    /// Create a queue of at least capacity elements in file (resized to bytesFor(capacity))
+    SpscQueue(File& file, size_t capacity) : Base(file,capacity) {};
+
+    /// Attach to a queue already created in file
+    SpscQueue(File& file) : Base(file) {};
+
+    /// Producer only. Returns false if the queue is full
+    bool push(const Typ& value)
+    {
+        uint64_t head = m_ctl->head.load(std::memory_order_relaxed);
+        if (head-m_cachedTail > m_mask)
+        {
+            m_cachedTail = m_ctl->tail.load(std::memory_order_acquire);
+            if (head-m_cachedTail > m_mask)
+            {
+                return false;
+            }
+        }
+        m_slots[head&m_mask] = value;
+        m_ctl->head.store(head+1,std::memory_order_release);
+        m_ctl->waker.wake();
+        return true;
+    };
+
+    /// Consumer only. Returns false if the queue is empty
+    bool pop(Typ& value)
+    {
+        uint64_t tail = m_ctl->tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead)
+        {
+            m_cachedHead = m_ctl->head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead)
+            {
+                return false;
+            }
+        }
+        value = m_slots[tail&m_mask];
+        m_ctl->tail.store(tail+1,std::memory_order_release);
+        return true;
+    };
+
+    /// Consumer only. Spin then sleep until an element arrives. Returns false on timeout
+    bool popWait(Typ& value, int timeoutMs=-1, unsigned spins=256)
+    {
+        return m_ctl->waker.wait([&]() {return pop(value);},spins,timeoutMs);
+    };
+};
+
+template <typename Typ>
+struct MpscSlot
+{
+    std::atomic<uint64_t> seq;
+    Typ value;
+};
+
+/*
+** Multiple producer, single consumer ring (after Dmitry Vyukov's bounded queue).
+** Producers claim slots with a compare-and-swap on head, and each slot carries a
+** sequence number telling the consumer when it has been filled. A producer
+** stopped between claiming and filling a slot holds up the consumer at that slot.
+*/
+template <typename Typ>
+class MpscQueue : public SharedQueueBase<Typ,MpscSlot<Typ>>
+{
+    typedef SharedQueueBase<Typ,MpscSlot<Typ>> Base;
+    using Base::m_ctl;
+    using Base::m_slots;
+    using Base::m_mask;
+
+public:
+    /// Create a queue of at least capacity elements in file (resized to bytesFor(capacity))
+    MpscQueue(File& file, size_t capacity) : Base(file,capacity)
+    {
+        for (uint64_t i=0; i<=m_mask; i++)
+        {
+            new (&m_slots[i].seq) std::atomic<uint64_t>(i);
+        }
+    };
+
+    /// Attach to a queue already created in file
+    MpscQueue(File& file) : Base(file) {};
+
+    /// Any number of producers. Returns false if the queue is full
+    bool push(const Typ& value)
+    {
+        uint64_t pos = m_ctl->head.load(std::memory_order_relaxed);
+        MpscSlot<Typ>* slot;
+        while (true)
+        {
+            slot = &m_slots[pos&m_mask];
+            uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            int64_t diff = int64_t(seq-pos);
+            if (diff == 0)
+            {
+                if (m_ctl->head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_ctl->head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->seq.store(pos+1,std::memory_order_release);
+        m_ctl->waker.wake();
+        return true;
+    };
+
+    /// Consumer only. Returns false if the queue is empty
+    bool pop(Typ& value)
+    {
+        uint64_t pos = m_ctl->tail.load(std::memory_order_relaxed);
+        MpscSlot<Typ>& slot = m_slots[pos&m_mask];
+        if (slot.seq.load(std::memory_order_acquire) != pos+1)
+        {
+            return false;
+        }
+        value = slot.value;
+        slot.seq.store(pos+m_mask+1,std::memory_order_release);
+        m_ctl->tail.store(pos+1,std::memory_order_release);
+        return true;
+    };
+
+    /// Consumer only. Spin then sleep until an element arrives. Returns false on timeout
+    bool popWait(Typ& value, int timeoutMs=-1, unsigned spins=256)
+    {
+        return m_ctl->waker.wait([&]() {return pop(value);},spins,timeoutMs);
+    };
+};
+
+}
+
+#endif
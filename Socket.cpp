@@ -4,10 +4,16 @@
 #include <set>
 #include <string>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <algorithm>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include "Socket.h"
+#include "Pipe.h"
+#include "Metrics.h"
 
 using namespace posixcpp;
 
@@ -26,6 +32,14 @@ Socket::Socket(int domain, int type, int protocol)
     m_file = File(fd,"socket");
 }
 
+Socket::Socket(File&& file)
+: m_file(std::move(file)),
+  m_domain(getsockopt(SOL_SOCKET,SO_DOMAIN)),
+  m_type(getsockopt(SOL_SOCKET,SO_TYPE)),
+  m_protocol(getsockopt(SOL_SOCKET,SO_PROTOCOL))
+{
+}
+
 bool Socket::shutdown(int how)
 {
     int r = ::shutdown(m_file.fd(),how);
@@ -41,9 +55,26 @@ bool Socket::shutdown(int how)
     throw PosixError("error in shutdown");
 }
 
+void Socket::setsockopt(int level, int optname, int value)
+{
+    int r = ::setsockopt(fd(),level,optname,&value,sizeof(value));
+    PosixError::ASSERT(r != -1,"setsockopt");
+}
+
+int Socket::getsockopt(int level, int optname) const
+{
+    int value = 0;
+    socklen_t len = sizeof(value);
+    int r = ::getsockopt(fd(),level,optname,&value,&len);
+    PosixError::ASSERT(r != -1,"getsockopt");
+    return value;
+}
+
 ssize_t Socket::send(const void *buf, size_t len, int flags) const
 {
+    POSIXCPP_METRIC_START();
     ssize_t r = ::send(fd(),buf,len,flags);
+    POSIXCPP_METRIC_END(SOCKET_SEND,r);
     PosixError::ASSERT(r != -1);
     return r;
 }
@@ -65,7 +96,9 @@ ssize_t Socket::sendmsg(const struct msghdr *msg, int flags) const
 
 ssize_t Socket::recv(void *buf, size_t len, int flags)
 {
+    POSIXCPP_METRIC_START();
     ssize_t r = ::recv(fd(),buf,len,flags);
+    POSIXCPP_METRIC_END(SOCKET_RECV,r);
     PosixError::ASSERT(r != -1);
     return r;
 }
@@ -86,6 +119,158 @@ ssize_t Socket::recvmsg(struct msghdr *msg, int flags)
     return r;
 }
 
+Result<ssize_t> Socket::trySend(const void *buf, size_t len, int flags) const noexcept
+{
+    POSIXCPP_METRIC_START();
+    ssize_t r = ::send(fd(),buf,len,flags);
+    POSIXCPP_METRIC_END(SOCKET_SEND,r);
+    return syscallResult(r);
+}
+
+Result<ssize_t> Socket::trySendto(const void *buf, size_t len, int flags,
+                                  const struct sockaddr *dest_addr, socklen_t addrlen) const noexcept
+{
+    return syscallResult(::sendto(fd(),buf,len,flags,dest_addr,addrlen));
+}
+
+Result<ssize_t> Socket::trySendmsg(const struct msghdr *msg, int flags) const noexcept
+{
+    return syscallResult(::sendmsg(fd(),msg,flags));
+}
+
+Result<ssize_t> Socket::tryRecv(void *buf, size_t len, int flags) noexcept
+{
+    POSIXCPP_METRIC_START();
+    ssize_t r = ::recv(fd(),buf,len,flags);
+    POSIXCPP_METRIC_END(SOCKET_RECV,r);
+    return syscallResult(r);
+}
+
+Result<ssize_t> Socket::tryRecvfrom(void *buf, size_t len, int flags,
+                                    struct sockaddr *src_addr, socklen_t *addrlen) noexcept
+{
+    return syscallResult(::recvfrom(fd(),buf,len,flags,src_addr,addrlen));
+}
+
+Result<ssize_t> Socket::tryRecvmsg(struct msghdr *msg, int flags) noexcept
+{
+    return syscallResult(::recvmsg(fd(),msg,flags));
+}
+
+int Socket::sendBatch(DatagramBatch& batch, unsigned count, int flags) const
+{
+    if (count > batch.capacity())
+    {
+        throw PosixError("sendBatch count exceeds batch capacity",EINVAL);
+    }
+    int r = ::sendmmsg(fd(),batch.msgs(),count,flags);
+    PosixError::ASSERT(r != -1,"sendmmsg");
+    return r;
+}
+
+int Socket::recvBatch(DatagramBatch& batch, unsigned count, int flags)
+{
+    if (count == 0)
+    {
+        count = batch.capacity();
+    }
+    if (count > batch.capacity())
+    {
+        throw PosixError("recvBatch count exceeds batch capacity",EINVAL);
+    }
+    batch.prepareRecv(count);
+    int r = ::recvmmsg(fd(),batch.msgs(),count,flags,nullptr);
+    PosixError::ASSERT(r != -1,"recvmmsg");
+    return r;
+}
+
+namespace
+{
+
+// Largest single hop through the pipe in the splice(2) fallback
+const size_t c_spliceChunk = 0x10000;
+
+// Block until fd is writable
+void waitWritable(int fd)
+{
+    pollfd pfd{fd,POLLOUT,0};
+    int r = ::poll(&pfd,1,-1);
+    PosixError::ASSERT(r!=-1 or errno==EINTR,"poll");
+}
+
+// Move len bytes from inFd to sockFd via splice(2) through a temporary pipe
+ssize_t spliceToSocket(int sockFd, int inFd, off_t* offset, size_t len)
+{
+    Pipe pipe;
+    size_t sent = 0;
+    while (sent < len)
+    {
+        ssize_t in = pipe.spliceFrom(inFd,std::min(len-sent,c_spliceChunk),offset);
+        if (in == 0)
+        {
+            break;
+        }
+        if (in == -1)
+        {
+            // A nonblocking input has nothing more for now
+            return sent ? ssize_t(sent) : -1;
+        }
+
+        // Everything in the pipe must reach the socket before the pipe goes away,
+        // so a nonblocking socket is waited on here rather than returning early
+        ssize_t left = in;
+        while (left > 0)
+        {
+            ssize_t out = pipe.spliceTo(sockFd,left);
+            if (out == -1)
+            {
+                waitWritable(sockFd);
+                continue;
+            }
+            left -= out;
+        }
+        sent += in;
+    }
+    return sent;
+}
+
+}
+
+ssize_t Socket::sendFile(const File& file, off_t offset, size_t len)
+{
+    off_t* offPtr = (offset < 0) ? nullptr : &offset;
+    size_t sent = 0;
+    while (sent < len)
+    {
+        ssize_t n = ::sendfile(fd(),file.fd(),offPtr,len-sent);
+        if (n > 0)
+        {
+            sent += n;
+            continue;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        if (errno == EAGAIN)
+        {
+            // A full nonblocking socket, told apart from end of file when nothing went out
+            return sent ? sent : -1;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if ((errno == EINVAL or errno == ENOSYS) and sent == 0)
+        {
+            // sendfile(2) does not support this input fd
+            return spliceToSocket(fd(),file.fd(),offPtr,len);
+        }
+        throw PosixError("sendfile");
+    }
+    return sent;
+}
+
 gai_vec_t Socket::getaddrinfo(const std::string& host, int *eaiVal)
 {
     struct addrinfo hints{0};
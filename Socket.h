@@ -8,6 +8,8 @@
 #include <netinet/in.h>
 #include "File.h"
 #include "PosixError.h"
+#include "DatagramBatch.h"
+#include "ScmRights.h"
 
 // A wrapper class for the fd produced from a socket() system call
 namespace posixcpp
@@ -32,15 +34,26 @@ public:
     // Ref. socket(2)
     Socket(int domain, int type, int protocol=0);
 
+    /// Take over an existing socket fd, e.g. from recvFds(). Reads domain, type and protocol from the fd
+    explicit Socket(File&& file);
+
     int fd() const {return m_file.fd();};
 
     int domain() const {return m_domain;};
+
+    int type() const {return m_type;};
  
     int protocol() const {return m_protocol;};
 
     // Returns true if no errors, false if ENOTCONN error, throws PosixError otherwise
     bool shutdown(int how=SHUT_RDWR);
 
+    /// Wrapper for setsockopt(2) for int valued options
+    void setsockopt(int level, int optname, int value);
+
+    /// Wrapper for getsockopt(2) for int valued options
+    int getsockopt(int level, int optname) const;
+
     // Returns empty vec if failed, *eaiVal is non-zero if failed
     // If non-NULL eaiVal will store status from getaddrinfo(3)
     gai_vec_t getaddrinfo(const std::string& host, int *eaiVal=NULL);
@@ -84,6 +97,62 @@ public:
 
     ssize_t recvmsg(struct msghdr *msg, int flags=0);
 
+    /*
+    ** noexcept versions of the calls above returning the errno in a Result,
+    ** e.g. for EAGAIN loops on nonblocking sockets. See File::tryRead()
+    */
+    Result<ssize_t> trySend(const void *buf, size_t len, int flags=0) const noexcept;
+
+    Result<ssize_t> trySendto(const void *buf, size_t len, int flags,
+                              const struct sockaddr *dest_addr, socklen_t addrlen) const noexcept;
+
+    Result<ssize_t> trySendmsg(const struct msghdr *msg, int flags=0) const noexcept;
+
+    Result<ssize_t> tryRecv(void *buf, size_t len, int flags=0) noexcept;
+
+    Result<ssize_t> tryRecvfrom(void *buf, size_t len, int flags,
+                                struct sockaddr *src_addr, socklen_t *addrlen) noexcept;
+
+    Result<ssize_t> tryRecvmsg(struct msghdr *msg, int flags=0) noexcept;
+
+    Result<ssize_t> tryRead(void *buf, size_t len) const noexcept
+    {
+        return m_file.tryRead(buf,len);
+    }
+
+    Result<ssize_t> tryWrite(const void *buf, size_t len) const noexcept
+    {
+        return m_file.tryWrite(buf,len);
+    }
+
+    /// Wrapper for sendmmsg(2). Sends slots [0,count) of batch. Returns the number of datagrams sent
+    int sendBatch(DatagramBatch& batch, unsigned count, int flags=0) const;
+
+    /// Wrapper for recvmmsg(2). Fills up to count slots of batch (0 = all). Returns the number received
+    int recvBatch(DatagramBatch& batch, unsigned count=0, int flags=0);
+
+    /*
+    ** Send len bytes of file starting at offset without copying through user space.
+    ** Uses sendfile(2), falling back to splice(2) through a pipe for fds sendfile
+    ** cannot handle. offset=-1 sends from (and advances) the file's own offset.
+    ** Returns the number of bytes sent, which is less than len at end of file or
+    ** when a nonblocking socket would block. Returns 0 only at end of file and
+    ** -1 if nothing could be sent because a nonblocking socket or input would block.
+    */
+    ssize_t sendFile(const File& file, off_t offset, size_t len);
+
+    /// Send descriptors over an AF_UNIX socket with SCM_RIGHTS. Returns the number of messages sent
+    size_t sendFds(std::span<const File> files) const
+    {
+        return posixcpp::sendFds(fd(),files);
+    }
+
+    /// Receive one message of descriptors sent with sendFds(). Empty only at end of file, see posixcpp::recvFds()
+    std::vector<File> recvFds(size_t maxFds=SCM_MAX_FDS)
+    {
+        return posixcpp::recvFds(fd(),maxFds);
+    }
+
     void close()
     {
         m_file.close();
@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include "File.h"
+#include "ScmRights.h"
 
 namespace posixcpp
 {
@@ -47,6 +48,30 @@ public:
         return m_writer;
     };
 
+    /// noexcept send(2) on writer(), e.g. with MSG_DONTWAIT. See File::tryWrite() for plain writes
+    Result<ssize_t> trySend(const void* buf, size_t len, int flags=0) noexcept
+    {
+        return syscallResult(::send(m_writer.fd(),buf,len,flags));
+    };
+
+    /// noexcept recv(2) on reader(). See File::tryRead() for plain reads
+    Result<ssize_t> tryRecv(void* buf, size_t len, int flags=0) noexcept
+    {
+        return syscallResult(::recv(m_reader.fd(),buf,len,flags));
+    };
+
+    /// Send descriptors through writer() with SCM_RIGHTS (AF_UNIX only). Returns the number of messages sent
+    size_t sendFds(std::span<const File> files)
+    {
+        return posixcpp::sendFds(m_writer.fd(),files);
+    };
+
+    /// Receive one message of descriptors on reader(). Empty only at end of file
+    std::vector<File> recvFds(size_t maxFds=SCM_MAX_FDS)
+    {
+        return posixcpp::recvFds(m_reader.fd(),maxFds);
+    };
+
 };
 
 }
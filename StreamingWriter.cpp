@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include "PosixError.h"
+#include "StreamingWriter.h"
+
+using namespace posixcpp;
+
+StreamingWriter::StreamingWriter(File& file, const Options& options)
+: m_file(file),
+  m_options(options),
+  m_start(file.lseek(0,SEEK_CUR)),
+  m_offset(m_start),
+  m_flushed(m_start),
+  m_done(m_start),
+  m_allocated(m_start)
+{
+    if (options.chunkSize == 0)
+    {
+        throw PosixError("StreamingWriter needs a non-zero chunkSize",EINVAL);
+    }
+}
+
+void StreamingWriter::preallocate(off_t end)
+{
+    if (m_options.preallocate == 0 or end <= m_allocated)
+    {
+        return;
+    }
+    off_t len = std::max<off_t>(m_options.preallocate,end-m_allocated);
+    try
+    {
+        m_file.fallocate(m_allocated,len,FALLOC_FL_KEEP_SIZE);
+        m_allocated += len;
+    }
+    catch (const PosixError& e)
+    {
+        if (e.errnoVal() != EOPNOTSUPP)
+        {
+            throw;
+        }
+        // Not supported here, write without it
+        m_options.preallocate = 0;
+    }
+}
+
+void StreamingWriter::writeBehind()
+{
+    off_t chunk = m_options.chunkSize;
+    while (m_offset-m_flushed >= chunk)
+    {
+        // Wait for the previous chunk, which has had a chunk's worth of writes to finish
+        if (m_done < m_flushed)
+        {
+            m_file.syncRange(m_done,m_flushed-m_done,
+                             SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+            if (m_options.dropCache)
+            {
+                m_file.fadvise(m_done,m_flushed-m_done,POSIX_FADV_DONTNEED);
+            }
+            m_done = m_flushed;
+        }
+        m_file.syncRange(m_flushed,chunk,SYNC_FILE_RANGE_WRITE);
+        m_flushed += chunk;
+    }
+}
+
+void StreamingWriter::write(const void* buf, size_t count)
+{
+    preallocate(m_offset+count);
+    const char* ptr = static_cast<const char*>(buf);
+    while (count > 0)
+    {
+        ssize_t n = m_file.write(ptr,count);
+        ptr += n;
+        count -= n;
+        m_offset += n;
+    }
+    writeBehind();
+}
+
+void StreamingWriter::finish()
+{
+    // Give back the preallocation past the end. Punching a hole beyond EOF is a no-op
+    // on ext4, but truncating to the current size frees the blocks
+    off_t size = m_file.getSize(false);
+    if (m_allocated > size)
+    {
+        m_file.ftruncate(size);
+    }
+    m_allocated = std::max(m_offset,size);
+    m_file.fdatasync();
+    if (m_options.dropCache and m_done < m_offset)
+    {
+        m_file.fadvise(m_done,m_offset-m_done,POSIX_FADV_DONTNEED);
+    }
+    m_flushed = m_done = m_offset;
+}
@@ -0,0 +1,75 @@
+#ifndef STREAMINGWRITER_H
+#define STREAMINGWRITER_H
+
+#include <sys/types.h>
+#include <cstddef>
+#include "File.h"
+
+namespace posixcpp
+{
+
+/*
+** Sequential writer for large outputs that keeps dirty data bounded.
+** Every chunk of output is handed to writeback as soon as it is complete,
+** with sync_file_range(2). The chunk before it is waited for and dropped
+** from the page cache with posix_fadvise(2). The final sync only has the
+** last couple of chunks left to write, instead of the whole file. The file
+** is also preallocated ahead of the writes, keeping its size, so it is
+** laid out in large extents.
+**
+** Writes go to the File's current offset. Not thread safe. Throws PosixError
+** like File. The destructor does not sync, call finish() for durability.
+*/
+class StreamingWriter
+{
+public:
+    struct Options
+    {
+        size_t chunkSize = 8<<20;      // write-behind granularity
+        size_t preallocate = 64<<20;   // extent allocated ahead of the writes, 0 for none
+        bool dropCache = true;         // fadvise(DONTNEED) data once it is on disk
+    };
+
+protected:
+    File& m_file;
+    Options m_options;
+    off_t m_start;      // file offset when constructed
+    off_t m_offset;     // end of the data written
+    off_t m_flushed;    // writeback started up to here
+    off_t m_done;       // written back (and dropped) up to here
+    off_t m_allocated;  // preallocated up to here
+
+    void writeBehind();
+    void preallocate(off_t end);
+
+public:
+    /// The File must outlive the StreamingWriter
+    StreamingWriter(File& file, const Options& options);
+    StreamingWriter(File& file) : StreamingWriter(file,Options()) {};
+
+    StreamingWriter(const StreamingWriter&) = delete;
+    StreamingWriter& operator=(const StreamingWriter&) = delete;
+
+    /// Write all count bytes, starting writeback of each completed chunk
+    void write(const void* buf, size_t count);
+
+    /// Write using a std::vector, std::string or std::array
+    template <typename Typ>
+    void write(const Typ& data)
+    {
+        write(&data[0],data.size()*sizeof(typename Typ::value_type));
+    };
+
+    /// Free the preallocation past the end of file, write back the rest and fdatasync(2) the file
+    void finish();
+
+    /// Bytes written so far
+    off_t written() const {return m_offset-m_start;};
+
+    /// Bytes not yet known to be written back
+    off_t pending() const {return m_offset-m_done;};
+};
+
+}
+
+#endif
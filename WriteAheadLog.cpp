@@ -0,0 +1,501 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+#include "MemMap.h"
+#include "PosixError.h"
+#include "WriteAheadLog.h"
+
+using namespace posixcpp;
+
+struct WriteAheadLog::SegmentHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t crc;       // of the fields below
+    uint64_t firstLsn;
+    uint64_t segmentSize;
+};
+
+struct WriteAheadLog::RecordHeader
+{
+    uint32_t crc;       // of size, lsn and the data
+    uint32_t size;      // of the data, the record is padded to 8 bytes
+    uint64_t lsn;
+};
+
+namespace
+{
+
+const uint64_t c_magic = 0x4c41575843505350ULL; // "PSPCXWAL"
+const uint32_t c_version = 1;
+const off_t c_headerSize = 64;                  // records start here
+const char c_suffix[] = ".wal";
+const char c_spareName[] = "spare.tmp";
+
+std::array<uint32_t,256> makeTable()
+{
+    std::array<uint32_t,256> table;
+    for (uint32_t i=0; i<256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit=0; bit<8; bit++)
+        {
+            crc = (crc & 1) ? (crc>>1)^0x82f63b78 : crc>>1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+uint32_t crcSoftware(const uint8_t* p, size_t size, uint32_t crc)
+{
+    static const std::array<uint32_t,256> table = makeTable();
+    while (size--)
+    {
+        crc = table[(crc^*p++)&0xff]^(crc>>8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t crcHardware(const uint8_t* p, size_t size, uint32_t crc)
+{
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t word;
+        memcpy(&word,p,8);
+        crc64 = _mm_crc32_u64(crc64,word);
+    }
+    crc = uint32_t(crc64);
+    while (size--)
+    {
+        crc = _mm_crc32_u8(crc,*p++);
+    }
+    return crc;
+}
+#endif
+
+size_t recordSize(size_t dataSize)
+{
+    return (sizeof(uint32_t)*2+sizeof(uint64_t)+dataSize+7) & ~size_t(7);
+}
+
+// CRC of a record: its size and lsn, then the data
+uint32_t recordCrc(uint32_t size, uint64_t lsn, const void* data)
+{
+    uint32_t crc = WriteAheadLog::crc32c(&size,sizeof(size));
+    crc = WriteAheadLog::crc32c(&lsn,sizeof(lsn),crc);
+    return WriteAheadLog::crc32c(data,size,crc);
+}
+
+}
+
+uint32_t WriteAheadLog::crc32c(const void* data, size_t size, uint32_t crc)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+#if defined(__x86_64__)
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    if (hardware)
+    {
+        return ~crcHardware(p,size,~crc);
+    }
+#endif
+    return ~crcSoftware(p,size,~crc);
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& dir, const Options& options, replay_t replay)
+: m_dir(dir),
+  m_options(options),
+  m_preparing(false),
+  m_dirDirty(false),
+  m_offset(0),
+  m_lastLsn(0),
+  m_durableLsn(0),
+  m_syncing(false),
+  m_error(0),
+  m_syncs(0)
+{
+    if (options.segmentSize < size_t(c_headerSize)+recordSize(0) or options.segmentSize > UINT32_MAX)
+    {
+        throw PosixError("WriteAheadLog segmentSize out of range",EINVAL);
+    }
+    if (::mkdir(dir.c_str(),0755) == -1 and errno != EEXIST)
+    {
+        throw PosixError(dir);
+    }
+    m_dirFile = File(dir,O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    recover(replay);
+    m_preparing = true;
+    prepareSpare();
+}
+
+std::string WriteAheadLog::segmentName(uint64_t firstLsn) const
+{
+    char name[32];
+    snprintf(name,sizeof(name),"%016llx%s",(unsigned long long)firstLsn,c_suffix);
+    return name;
+}
+
+off_t WriteAheadLog::scan(File& file, uint64_t firstLsn, const replay_t& replay, uint64_t& nextLsn)
+{
+    nextLsn = firstLsn;
+    size_t size = file.getSize(false);
+    if (size < size_t(c_headerSize))
+    {
+        return 0;
+    }
+    MemMap<char> map(file,size,0,MAP_SHARED_,PROT_READ_);
+    map.advise(MADV_SEQUENTIAL_);
+    const char* base = map.get();
+
+    SegmentHeader header;
+    memcpy(&header,base,sizeof(header));
+    uint32_t crc = crc32c(&header.firstLsn,sizeof(header)-offsetof(SegmentHeader,firstLsn));
+    if (header.magic != c_magic or header.version != c_version or header.crc != crc or
+        header.firstLsn != firstLsn)
+    {
+        return 0;
+    }
+
+    off_t offset = c_headerSize;
+    RecordHeader record;
+    while (size_t(offset)+sizeof(record) <= size)
+    {
+        memcpy(&record,base+offset,sizeof(record));
+        const char* data = base+offset+sizeof(record);
+        if (record.lsn != nextLsn or record.size > size-offset-sizeof(record) or
+            record.crc != recordCrc(record.size,record.lsn,data))
+        {
+            break;
+        }
+        if (replay)
+        {
+            replay(record.lsn,std::string_view(data,record.size));
+        }
+        nextLsn++;
+        offset += recordSize(record.size);
+    }
+    return offset;
+}
+
+void WriteAheadLog::recover(const replay_t& replay)
+{
+    std::vector<uint64_t> found;
+    DIR* dir = ::opendir(m_dir.c_str());
+    PosixError::ASSERT(dir!=nullptr,"opendir");
+    while (dirent* d = ::readdir(dir))
+    {
+        std::string_view name = d->d_name;
+        size_t nameLen = 16+sizeof(c_suffix)-1;
+        if (name.size() != nameLen or name.substr(16) != c_suffix or
+            name.find_first_not_of("0123456789abcdef") != 16)
+        {
+            continue;
+        }
+        found.push_back(strtoull(d->d_name,nullptr,16));
+    }
+    ::closedir(dir);
+    std::sort(found.begin(),found.end());
+    if (::unlinkat(m_dirFile.fd(),c_spareName,0) == -1 and errno != ENOENT)
+    {
+        throw PosixError("unlinkat");
+    }
+
+    // Replay up to the first bad record, keeping the segments before it
+    uint64_t nextLsn = found.empty() ? 1 : found[0];
+    off_t end = 0; // of the records in the last good segment
+    size_t i = 0;
+    for (; i<found.size() and found[i] == nextLsn; i++)
+    {
+        File file = m_dirFile.openat(segmentName(found[i]),O_RDWR|O_CLOEXEC);
+        uint64_t next;
+        off_t offset = scan(file,found[i],replay,next);
+        if (offset == 0)
+        {
+            // e.g. a crash inside openSegment(), the previous segment stays current
+            break;
+        }
+        end = offset;
+        nextLsn = next;
+        m_segments.push_back(found[i]);
+        m_segment = SharedFile(std::move(file));
+        if (i+1 == found.size() or found[i+1] != nextLsn)
+        {
+            i++;
+            break;
+        }
+    }
+    for (; i<found.size(); i++)
+    {
+        int r = ::unlinkat(m_dirFile.fd(),segmentName(found[i]).c_str(),0);
+        PosixError::ASSERT(r!=-1,"unlinkat");
+    }
+    m_lastLsn = m_durableLsn = nextLsn-1;
+
+    if (m_segments.empty())
+    {
+        openSegment(nextLsn);
+        return;
+    }
+
+    // Zero whatever follows the last record, so a stale record can never follow a new one
+    m_offset = end;
+    off_t size = m_segment->getSize(false);
+    if (m_offset < size)
+    {
+        try
+        {
+            m_segment->fallocate(m_offset,size-m_offset,FALLOC_FL_ZERO_RANGE);
+        }
+        catch (const PosixError& e)
+        {
+            if (e.errnoVal() != EOPNOTSUPP)
+            {
+                throw;
+            }
+            m_segment->fallocate(m_offset,size-m_offset,FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE);
+        }
+        m_segment->fdatasync();
+    }
+    m_dirFile.fsync();
+}
+
+File WriteAheadLog::createSegment(const std::string& name) const
+{
+    File file = m_dirFile.openat(name,O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+    try
+    {
+        file.fallocate(0,m_options.segmentSize);
+    }
+    catch (const PosixError& e)
+    {
+        if (e.errnoVal() != EOPNOTSUPP)
+        {
+            throw;
+        }
+        file.ftruncate(m_options.segmentSize);
+    }
+    return file;
+}
+
+void WriteAheadLog::writeHeader(File& file, uint64_t firstLsn) const
+{
+    char block[c_headerSize] = {};
+    SegmentHeader header{c_magic,c_version,0,firstLsn,m_options.segmentSize};
+    header.crc = crc32c(&header.firstLsn,sizeof(header)-offsetof(SegmentHeader,firstLsn));
+    memcpy(block,&header,sizeof(header));
+    PosixError::ASSERT(file.pwrite(block,sizeof(block),0)==sizeof(block),"WriteAheadLog segment header");
+}
+
+void WriteAheadLog::openSegment(uint64_t firstLsn)
+{
+    File file = createSegment(segmentName(firstLsn));
+    writeHeader(file,firstLsn);
+    file.fdatasync();
+    m_dirFile.fsync();
+    m_segment = SharedFile(std::move(file));
+    m_segments.push_back(firstLsn);
+    m_offset = c_headerSize;
+}
+
+void WriteAheadLog::rotate()
+{
+    uint64_t firstLsn = m_lastLsn+1;
+    std::string name = segmentName(firstLsn);
+    SharedFile next;
+    if (m_spare)
+    {
+        writeHeader(*m_spare,firstLsn);
+        int r = ::renameat(m_dirFile.fd(),c_spareName,m_dirFile.fd(),name.c_str());
+        PosixError::ASSERT(r!=-1,"renameat");
+        next = std::move(m_spare);
+        m_spare = SharedFile();
+    }
+    else
+    {
+        // Rotated again before the spare was ready
+        next = SharedFile(createSegment(name));
+        writeHeader(*next,firstLsn);
+    }
+    // Only now that nothing can throw does the old segment move to m_unsynced.
+    // The next sync makes the new name durable along with the data
+    m_unsynced.push_back(m_segment);
+    m_segment = next;
+    m_segments.push_back(firstLsn);
+    m_offset = c_headerSize;
+    m_dirDirty = true;
+}
+
+void WriteAheadLog::prepareSpare()
+{
+    SharedFile spare;
+    try
+    {
+        spare = SharedFile(createSegment(c_spareName));
+    }
+    catch (const PosixError&)
+    {
+        // Not fatal, rotate() creates the segment itself and reports the error there
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_preparing = false;
+    if (not m_spare)
+    {
+        m_spare = std::move(spare);
+    }
+}
+
+void WriteAheadLog::throwIfFailed() const
+{
+    if (m_error)
+    {
+        throw PosixError("WriteAheadLog: an earlier sync failed",m_error);
+    }
+}
+
+size_t WriteAheadLog::maxRecordSize() const
+{
+    return m_options.segmentSize-c_headerSize-recordSize(0);
+}
+
+uint64_t WriteAheadLog::append(const void* data, size_t size)
+{
+    if (size > maxRecordSize())
+    {
+        throw PosixError("WriteAheadLog record larger than a segment",EMSGSIZE);
+    }
+    size_t total = recordSize(size);
+    uint64_t padding = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    throwIfFailed();
+    if (m_offset+total > m_options.segmentSize)
+    {
+        rotate();
+    }
+    uint64_t lsn = m_lastLsn+1;
+    RecordHeader record{recordCrc(uint32_t(size),lsn,data),uint32_t(size),lsn};
+    std::array<iovec,3> iov{{
+        {&record,sizeof(record)},
+        {const_cast<void*>(data),size},
+        {&padding,total-sizeof(record)-size},
+    }};
+    ssize_t n = m_segment->pwritev2(iov,m_offset);
+    if (n != ssize_t(total))
+    {
+        // Leaves a torn record, which the next append overwrites
+        throw PosixError("WriteAheadLog short write",EIO);
+    }
+    m_offset += total;
+    m_lastLsn = lsn;
+    if (not m_spare and not m_preparing)
+    {
+        m_preparing = true;
+        lock.unlock();
+        prepareSpare();
+    }
+    return lsn;
+}
+
+void WriteAheadLog::sync(uint64_t lsn)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (lsn > m_lastLsn)
+    {
+        throw PosixError("WriteAheadLog::sync past the last record",EINVAL);
+    }
+    while (m_durableLsn < lsn)
+    {
+        throwIfFailed();
+        if (m_syncing)
+        {
+            // A sync is running, it may or may not cover lsn
+            m_synced.wait(lock);
+            continue;
+        }
+
+        // Lead a sync of everything appended so far
+        m_syncing = true;
+        uint64_t target = m_lastLsn;
+        bool dirDirty = m_dirDirty;
+        m_dirDirty = false;
+        std::vector<SharedFile> files = std::move(m_unsynced);
+        m_unsynced.clear();
+        files.push_back(m_segment);
+        lock.unlock();
+        int error = 0;
+        try
+        {
+            for (auto& file : files)
+            {
+                file->fdatasync();
+            }
+            if (dirDirty)
+            {
+                m_dirFile.fsync();
+            }
+        }
+        catch (const PosixError& e)
+        {
+            error = e.errnoVal();
+        }
+        lock.lock();
+        m_syncing = false;
+        m_syncs++;
+        if (error)
+        {
+            m_error = error;
+        }
+        else
+        {
+            m_durableLsn = std::max(m_durableLsn,target);
+        }
+        m_synced.notify_all();
+    }
+}
+
+void WriteAheadLog::releaseUpTo(uint64_t lsn)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A segment's records end where the next one starts, the current segment is kept
+    while (m_segments.size() > 1 and m_segments[1] <= lsn+1)
+    {
+        int r = ::unlinkat(m_dirFile.fd(),segmentName(m_segments[0]).c_str(),0);
+        PosixError::ASSERT(r!=-1,"unlinkat");
+        m_segments.erase(m_segments.begin());
+    }
+}
+
+uint64_t WriteAheadLog::lastLsn()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastLsn;
+}
+
+uint64_t WriteAheadLog::durableLsn()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_durableLsn;
+}
+
+uint64_t WriteAheadLog::syncs()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_syncs;
+}
+
+size_t WriteAheadLog::segments()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_segments.size();
+}
@@ -0,0 +1,138 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "File.h"
+#include "SharedFile.h"
+
+namespace posixcpp
+{
+
+/*
+** An append-only log of records in a directory of preallocated segment files.
+**
+** Each record gets the next log sequence number (LSN), counting from 1, and
+** is framed with its size, LSN and a CRC32C. Segments are named after the
+** hex LSN of their first record and are allocated in full when created, so
+** appends do not grow the file and fdatasync(2) has no size to update. A
+** record that does not fit in the current segment starts the next one. The
+** next segment is allocated ahead, outside the lock, so rotating is only a
+** header write and a rename.
+**
+** Group commit: append() only writes the record. sync(lsn) returns once the
+** record is on disk. One caller at a time runs fdatasync(2) for everything
+** appended so far. The others wait for it and find their records covered,
+** so N concurrent committers usually share one sync.
+**
+** On open the segments are read through a read-only mapping, and each valid
+** record goes to the replay callback. The log ends at the first torn or
+** corrupt record. The rest of that segment is zeroed, and later segments are
+** removed.
+**
+** Thread safe. Throws PosixError. Once a sync fails every later append()
+** and sync() throws its errno, since what reached the disk is unknown.
+*/
+class WriteAheadLog
+{
+public:
+    struct Options
+    {
+        size_t segmentSize = 64<<20;
+    };
+
+    /// Called for each recovered record, in order
+    typedef std::function<void(uint64_t lsn, std::string_view record)> replay_t;
+
+    /// CRC32C (Castagnoli) of data, continuing from crc. Uses the SSE4.2 instruction where available
+    static uint32_t crc32c(const void* data, size_t size, uint32_t crc=0);
+
+protected:
+    struct SegmentHeader;
+    struct RecordHeader;
+
+    std::string m_dir;
+    Options m_options;
+    File m_dirFile;
+
+    std::mutex m_mutex;
+    std::condition_variable m_synced;
+    SharedFile m_segment;               // being appended to
+    SharedFile m_spare;                 // allocated ahead for the next rotation, if any
+    bool m_preparing;                   // m_spare is being allocated
+    bool m_dirDirty;                    // segments named since the last sync
+    std::vector<SharedFile> m_unsynced; // full segments not yet synced
+    std::vector<uint64_t> m_segments;   // first LSN of each segment, oldest first
+    off_t m_offset;                     // end of the records in m_segment
+    uint64_t m_lastLsn;
+    uint64_t m_durableLsn;
+    bool m_syncing;
+    int m_error;
+    uint64_t m_syncs;
+
+    std::string segmentName(uint64_t firstLsn) const;
+    void recover(const replay_t& replay);
+    // Replay one segment. Returns the end of its valid records, or 0 if the header is bad
+    off_t scan(File& file, uint64_t firstLsn, const replay_t& replay, uint64_t& nextLsn);
+    // Create and allocate a segment file, without a header. Does not need the lock
+    File createSegment(const std::string& name) const;
+    void writeHeader(File& file, uint64_t firstLsn) const;
+    // Create the first segment at startup, synced
+    void openSegment(uint64_t firstLsn);
+    // Switch to a new segment for the next record, using m_spare if there is one. Needs the lock
+    void rotate();
+    // Allocate m_spare outside the lock. Called with m_preparing set
+    void prepareSpare();
+    void throwIfFailed() const;
+
+public:
+    /// Open or create the log in dir, replaying the existing records
+    WriteAheadLog(const std::string& dir, const Options& options, replay_t replay=nullptr);
+    WriteAheadLog(const std::string& dir) : WriteAheadLog(dir,Options()) {};
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /// Write a record, not yet durable. Returns its LSN
+    uint64_t append(const void* data, size_t size);
+
+    uint64_t append(std::string_view data) {return append(data.data(),data.size());};
+
+    /// Wait until every record up to lsn is durable, syncing or joining a sync in progress. EINVAL past lastLsn()
+    void sync(uint64_t lsn);
+
+    /// append() then sync()
+    uint64_t commit(const void* data, size_t size)
+    {
+        uint64_t lsn = append(data,size);
+        sync(lsn);
+        return lsn;
+    };
+
+    uint64_t commit(std::string_view data) {return commit(data.data(),data.size());};
+
+    /// Remove the segments holding only records up to lsn, e.g. after a checkpoint
+    void releaseUpTo(uint64_t lsn);
+
+    uint64_t lastLsn();
+
+    uint64_t durableLsn();
+
+    /// Number of fdatasync rounds so far, commits per sync measures the grouping
+    uint64_t syncs();
+
+    /// Number of segment files
+    size_t segments();
+
+    /// Largest record that fits in a segment
+    size_t maxRecordSize() const;
+};
+
+}
+
+#endif
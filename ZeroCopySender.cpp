@@ -0,0 +1,161 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <cerrno>
+#include "PosixError.h"
+#include "ZeroCopySender.h"
+
+using namespace posixcpp;
+
+ZeroCopySender::ZeroCopySender(Socket& socket, size_t threshold)
+: m_socket(socket),
+  m_threshold(threshold),
+  m_nextId(0),
+  m_completed(0),
+  m_copied(0)
+{
+    m_socket.setsockopt(SOL_SOCKET,SO_ZEROCOPY,1);
+}
+
+ssize_t ZeroCopySender::send(const void* buf, size_t len, release_t release, int flags)
+{
+    if (len < m_threshold)
+    {
+        ssize_t n = m_socket.send(buf,len,flags);
+        if (release)
+        {
+            release();
+        }
+        return n;
+    }
+
+    const char* ptr = static_cast<const char*>(buf);
+    const uint32_t firstId = m_nextId;
+    size_t sent = 0;
+    int err = 0;
+    bool copy = false;
+    // Nothing in the loop throws, so a release for the parts already handed over is always queued below
+    while (sent < len)
+    {
+        ssize_t n = ::send(m_socket.fd(),ptr+sent,len-sent,copy ? flags : flags|MSG_ZEROCOPY);
+        if (n >= 0)
+        {
+            if (not copy)
+            {
+                // Every successful MSG_ZEROCOPY send consumes one notification id
+                m_nextId++;
+            }
+            sent += n;
+            copy = false;
+            continue;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == ENOBUFS and not copy)
+        {
+            // Out of socket option memory for pinning pages, copy this part instead
+            copy = true;
+            continue;
+        }
+        if (errno != EAGAIN or sent == 0)
+        {
+            err = errno;
+        }
+        break;
+    }
+
+    if (m_nextId == firstId)
+    {
+        // The kernel holds no part of the buffer
+        if (release and err == 0)
+        {
+            release();
+        }
+    }
+    else
+    {
+        m_pending.push_back(Pending{m_nextId-1,release});
+    }
+    if (err != 0)
+    {
+        throw PosixError("send(MSG_ZEROCOPY)",err);
+    }
+    return sent;
+}
+
+unsigned ZeroCopySender::releaseUpTo(uint32_t id)
+{
+    unsigned released = 0;
+    while (not m_pending.empty() and int32_t(m_pending.front().id - id) <= 0)
+    {
+        release_t release = std::move(m_pending.front().release);
+        m_pending.pop_front();
+        if (release)
+        {
+            release();
+        }
+        released++;
+    }
+    return released;
+}
+
+unsigned ZeroCopySender::reap()
+{
+    unsigned released = 0;
+    while (true)
+    {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t r = ::recvmsg(m_socket.fd(),&msg,MSG_ERRQUEUE|MSG_DONTWAIT);
+        if (r == -1 and errno == EINTR)
+        {
+            continue;
+        }
+        if (r == -1 and errno == EAGAIN)
+        {
+            break;
+        }
+        PosixError::ASSERT(r != -1,"recvmsg(MSG_ERRQUEUE)");
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg,cm))
+        {
+            bool isRecvErr = (cm->cmsg_level == SOL_IP and cm->cmsg_type == IP_RECVERR) or
+                             (cm->cmsg_level == SOL_IPV6 and cm->cmsg_type == IPV6_RECVERR);
+            if (not isRecvErr)
+            {
+                continue;
+            }
+            auto ee = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+            if (ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY or ee->ee_errno != 0)
+            {
+                continue;
+            }
+            // Notifications cover the inclusive id range [ee_info,ee_data]
+            uint32_t count = ee->ee_data - ee->ee_info + 1;
+            m_completed += count;
+            if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                m_copied += count;
+            }
+            released += releaseUpTo(ee->ee_data);
+        }
+    }
+    return released;
+}
+
+void ZeroCopySender::waitAll()
+{
+    while (not m_pending.empty())
+    {
+        // A non-empty error queue is reported as POLLERR
+        pollfd pfd{m_socket.fd(),0,0};
+        int r = ::poll(&pfd,1,-1);
+        PosixError::ASSERT(r != -1 or errno == EINTR,"poll");
+        reap();
+    }
+}
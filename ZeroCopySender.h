@@ -0,0 +1,73 @@
+#ifndef ZEROCOPYSENDER_H
+#define ZEROCOPYSENDER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include "Socket.h"
+
+namespace posixcpp
+{
+
+/*
+** Sends with MSG_ZEROCOPY on a TCP Socket (ref. Documentation/networking/msg_zerocopy.rst).
+** The kernel keeps using the caller's buffer after send() returns, so the
+** buffer must not be modified or freed until its release callback runs.
+** Callbacks run from reap() or waitAll(), in send order. Messages smaller than
+** the threshold are copied with a plain send() and released immediately.
+*/
+class ZeroCopySender
+{
+public:
+    typedef std::function<void()> release_t;
+
+    /// Below 10 KiB the page pinning costs more than the copy it saves
+    static const size_t DEFAULT_THRESHOLD = 10*1024;
+
+protected:
+    struct Pending
+    {
+        uint32_t id;
+        release_t release;
+    };
+
+    Socket& m_socket;
+    size_t m_threshold;
+    uint32_t m_nextId;      // id the kernel gives the next zerocopy send
+    std::deque<Pending> m_pending;
+    uint64_t m_completed;   // zerocopy sends the kernel has released
+    uint64_t m_copied;      // of those, how many the kernel copied anyway
+
+    unsigned releaseUpTo(uint32_t id);
+
+public:
+    /// Sets SO_ZEROCOPY on the socket. Throws PosixError if the kernel does not support it
+    ZeroCopySender(Socket& socket, size_t threshold=DEFAULT_THRESHOLD);
+
+    ZeroCopySender(const ZeroCopySender&) = delete;
+    ZeroCopySender& operator=(const ZeroCopySender&) = delete;
+
+    /// Send buf, calling release once the kernel is done with it. Returns bytes sent (short only if nonblocking)
+    ssize_t send(const void* buf, size_t len, release_t release=nullptr, int flags=0);
+
+    /// Process completion notifications from the error queue without blocking. Returns the number of releases
+    unsigned reap();
+
+    /// Block until every outstanding buffer has been released
+    void waitAll();
+
+    /// Number of buffers the kernel still holds
+    size_t pending() const {return m_pending.size();};
+
+    /// Count of zerocopy sends completed by the kernel
+    uint64_t completed() const {return m_completed;};
+
+    /// Count of completed sends where the kernel fell back to copying (e.g. loopback)
+    uint64_t copied() const {return m_copied;};
+
+    size_t threshold() const {return m_threshold;};
+};
+
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <memory>
+#include "tests/Loopback.h"
+
+// Minimal timing helpers shared by the benchmark programs
+
+namespace bench
+{
+
+typedef std::chrono::steady_clock clock_t;
+
+// Returns the seconds taken by fn()
+template <typename Fn>
+double timeIt(Fn&& fn)
+{
+    auto start = clock_t::now();
+    fn();
+    std::chrono::duration<double> elapsed = clock_t::now()-start;
+    return elapsed.count();
+}
+
+// Print one result line: name, size, seconds, rate
+inline void report(const std::string& name, size_t size, double seconds, double ops, double bytes)
+{
+    printf("%-32s %8zu  %8.3f s  %12.0f ops/s  %10.1f MB/s\n",
+           name.c_str(),size,seconds,ops/seconds,bytes/seconds/1e6);
+}
+
+// A connected TCP pair over loopback, shared with the testers
+typedef posixcpp::Loopback Loopback;
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include <vector>
+#include <cstdlib>
+#include "File.h"
+#include "BufferedFile.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Compare one File::write per record against BufferedFile for record sizes 16 B to 4 KiB
+// Usage: BufferedFileBench [totalMB] [bufferKB]
+
+static const char* c_filename = "buffered_bench.dat";
+
+int main(int argc, char* argv[])
+{
+    size_t total = ((argc > 1) ? atol(argv[1]) : 64) << 20;
+    size_t bufferSize = ((argc > 2) ? atol(argv[2]) : 64) << 10;
+
+    File file(c_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    for (size_t size=16; size<=4096; size*=4)
+    {
+        std::vector<char> record(size,'r');
+        record.back() = '\n';
+        size_t count = total/size;
+
+        file.ftruncate(0);
+        file.lseek(0);
+        double secs = bench::timeIt([&]() {
+            for (size_t i=0; i<count; i++)
+            {
+                file.write(&record[0],size);
+            }
+        });
+        bench::report("File::write",size,secs,count,total);
+
+        file.ftruncate(0);
+        file.lseek(0);
+        secs = bench::timeIt([&]() {
+            BufferedFile out(file,bufferSize);
+            for (size_t i=0; i<count; i++)
+            {
+                out.write(&record[0],size);
+            }
+            out.flush();
+        });
+        bench::report("BufferedFile::write",size,secs,count,total);
+
+        file.lseek(0);
+        size_t lines = 0;
+        secs = bench::timeIt([&]() {
+            BufferedFile in(file,bufferSize);
+            while (in.readLine())
+            {
+                lines++;
+            }
+        });
+        bench::report("BufferedFile::readLine",size,secs,lines,total);
+    }
+    file.unlink();
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include "Socket.h"
+#include "DatagramBatch.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Compare per-packet Socket::recvfrom against Socket::recvBatch on loopback UDP
+// Usage: DatagramBatchBench [packets] [batchSize] [packetSize]
+
+// Loopback receiver with a large buffer and a receive timeout to notice the end
+static sockaddr_in bindReceiver(const Socket& sock)
+{
+    sockaddr_in addr = bindLoopback(sock);
+    int rcvbuf = 8<<20;
+    ::setsockopt(sock.fd(),SOL_SOCKET,SO_RCVBUF,&rcvbuf,sizeof(rcvbuf));
+    timeval tv{0,200000};
+    ::setsockopt(sock.fd(),SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof(tv));
+    return addr;
+}
+
+// Blast packets at the receiver with sendBatch until told to stop
+static void sender(const sockaddr_in& dest, unsigned batchSize, size_t packetSize, std::atomic<bool>& stop)
+{
+    Socket sock(AF_INET,SOCK_DGRAM);
+    DatagramBatch batch(batchSize,packetSize);
+    for (unsigned i=0; i<batchSize; i++)
+    {
+        memset(batch.data(i),'p',packetSize);
+        batch.setSize(i,packetSize);
+        batch.setAddr(i,(const sockaddr*)&dest,sizeof(dest));
+    }
+    while (not stop.load(std::memory_order_relaxed))
+    {
+        sock.sendBatch(batch,batchSize);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t packets = (argc > 1) ? atol(argv[1]) : 1000000;
+    unsigned batchSize = (argc > 2) ? atoi(argv[2]) : 64;
+    size_t packetSize = (argc > 3) ? atol(argv[3]) : 64;
+
+    for (bool batched : {false,true})
+    {
+        Socket receiver(AF_INET,SOCK_DGRAM);
+        sockaddr_in addr = bindReceiver(receiver);
+        std::atomic<bool> stop{false};
+        std::thread thread(sender,addr,batchSize,packetSize,std::ref(stop));
+
+        DatagramBatch batch(batchSize,packetSize);
+        std::vector<char> buf(packetSize);
+        size_t got = 0;
+        double secs = bench::timeIt([&]() {
+            try
+            {
+                while (got < packets)
+                {
+                    if (batched)
+                    {
+                        got += receiver.recvBatch(batch,0,MSG_WAITFORONE);
+                    }
+                    else
+                    {
+                        sockaddr_storage from;
+                        socklen_t fromLen = sizeof(from);
+                        receiver.recvfrom(&buf[0],buf.size(),0,(sockaddr*)&from,&fromLen);
+                        got++;
+                    }
+                }
+            }
+            catch (const PosixError& e)
+            {
+                // Receive timeout - the sender stalled
+            }
+        });
+        stop = true;
+        thread.join();
+        bench::report(batched ? "Socket::recvBatch" : "Socket::recvfrom",packetSize,secs,got,got*packetSize);
+    }
+    return 0;
+}
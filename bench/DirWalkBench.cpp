@@ -0,0 +1,82 @@
+#include <dirent.h>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include "File.h"
+#include "DirWalker.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Walk a generated tree: opendir(3) plus File per path, against DirWalker with 1 and N threads
+// Usage: DirWalkBench [dirs] [filesPerDir]
+
+static const std::string c_root = "dirwalk_bench.d";
+
+// The walk we had: list with readdir(3), then open or stat every entry by its full path
+static size_t naiveWalk(const std::string& path)
+{
+    size_t count = 0;
+    DIR* dir = ::opendir(path.c_str());
+    PosixError::ASSERT(dir!=nullptr,"opendir");
+    while (dirent* d = ::readdir(dir))
+    {
+        std::string name = d->d_name;
+        if (name == "." or name == "..")
+        {
+            continue;
+        }
+        std::string child = path+"/"+name;
+        count++;
+        struct stat st = File::lstat(child);
+        if (S_ISDIR(st.st_mode))
+        {
+            File sub(child,O_RDONLY|O_DIRECTORY);
+            count += naiveWalk(child);
+        }
+    }
+    ::closedir(dir);
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t dirs = (argc > 1) ? atol(argv[1]) : 200;
+    size_t files = (argc > 2) ? atol(argv[2]) : 100;
+
+    File::mkdir(c_root,0755);
+    for (size_t d=0; d<dirs; d++)
+    {
+        // Two levels deep: root/aN/bM
+        std::string mid = c_root+"/a"+std::to_string(d%16);
+        if (d < 16)
+        {
+            File::mkdir(mid,0755);
+        }
+        std::string dir = mid+"/b"+std::to_string(d);
+        File::mkdir(dir,0755);
+        for (size_t f=0; f<files; f++)
+        {
+            File(dir+"/f"+std::to_string(f),O_WRONLY|O_CREAT,0644);
+        }
+    }
+
+    size_t count = 0;
+    double secs = bench::timeIt([&]() {count = naiveWalk(c_root);});
+    bench::report("readdir+File per path",count,secs,count,0);
+
+    unsigned cpus = std::max(1U,std::thread::hardware_concurrency());
+    for (unsigned threads : {1U,cpus,4*cpus})
+    {
+        DirWalker walker(threads);
+        DirWalker::Stats stats;
+        secs = bench::timeIt([&]() {
+            stats = walker.walk(c_root,[](const DirWalker::Entry&) {return true;});
+        });
+        bench::report("DirWalker threads="+std::to_string(threads),stats.entries,secs,stats.entries,0);
+    }
+
+    ::system(("rm -rf "+c_root).c_str());
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "File.h"
+#include "AlignedBufferPool.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Buffered against O_DIRECT reads of a file read once, sequentially in large
+// blocks and at random 4k offsets. Each run starts with the file out of the
+// page cache, and reports how much of it the run left cached.
+// Usage: DirectIoBench [fileMB] [randomReads]
+
+static const std::string c_filename = "directio_bench.dat";
+
+// Percentage of the file's pages in the page cache
+static double cachedPercent(const File& file, size_t size)
+{
+    void* addr = ::mmap(nullptr,size,PROT_READ,MAP_SHARED,file.fd(),0);
+    PosixError::ASSERT(addr!=MAP_FAILED,"mmap");
+    size_t pages = (size+4095)/4096;
+    std::vector<unsigned char> vec(pages);
+    PosixError::ASSERT(::mincore(addr,size,&vec[0])==0,"mincore");
+    ::munmap(addr,size);
+    size_t resident = 0;
+    for (auto v : vec)
+    {
+        resident += v & 1;
+    }
+    return 100.0*resident/pages;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t size = ((argc > 1) ? atol(argv[1]) : 256) << 20;
+    size_t randomReads = (argc > 2) ? atol(argv[2]) : 20000;
+    const size_t block = 1<<20;
+    const size_t small = 4096;
+
+    AlignedBufferPool pool(block,1);
+    AlignedBuffer buf = pool.acquire();
+    {
+        File out(c_filename,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        memset(buf.data(),'d',buf.size());
+        for (size_t done=0; done<size; done+=block)
+        {
+            out.write(buf.data(),block);
+        }
+        out.fsync();
+    }
+
+    std::mt19937_64 rng(1);
+    std::vector<off_t> offsets(randomReads);
+    for (auto& off : offsets)
+    {
+        off = (rng()%(size/small))*small;
+    }
+
+    for (bool direct : {false,true})
+    {
+        File file(c_filename,direct ? O_RDONLY|O_DIRECT : O_RDONLY);
+        const char* mode = direct ? "direct" : "buffered";
+
+        file.fadvise(0,0,POSIX_FADV_DONTNEED);
+        size_t total = 0;
+        double secs = bench::timeIt([&]() {
+            for (off_t off=0; off<off_t(size); off+=block)
+            {
+                total += file.pread(buf.data(),block,off);
+            }
+        });
+        bench::report(std::string(mode)+" sequential 1M",block,secs,size/block,total);
+        printf("  cached after: %.0f%%\n",cachedPercent(file,size));
+
+        file.fadvise(0,0,POSIX_FADV_DONTNEED);
+        secs = bench::timeIt([&]() {
+            for (off_t off : offsets)
+            {
+                file.pread(buf.data(),small,off);
+            }
+        });
+        bench::report(std::string(mode)+" random 4k",small,secs,randomReads,randomReads*small);
+        printf("  cached after: %.0f%%\n",cachedPercent(file,size));
+    }
+
+    File(c_filename).remove();
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <vector>
+#include "FdDispatcher.h"
+#include "Pipe.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Connections handed from an acceptor to a forked worker per second, for several batch sizes
+// Usage: FdHandoffBench [connections]
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 100000;
+
+    // Stand in for accepted connections: one connected TCP pair, duplicated
+    bench::Loopback loopback;
+
+    for (size_t batch : {1,16,128})
+    {
+        size_t total = count/batch*batch;
+        FdDispatcher dispatcher(1);
+        Pipe done;
+        pid_t pid = ::fork();
+        PosixError::ASSERT(pid!=-1,"fork");
+        if (pid == 0)
+        {
+            File channel = dispatcher.workerSide(0);
+            size_t received = 0;
+            while (received < total)
+            {
+                received += FdDispatcher::receive(channel).size();
+            }
+            done.writer().write("x",1);
+            _exit(0);
+        }
+        dispatcher.acceptorSide();
+
+        std::vector<File> conns;
+        for (size_t i=0; i<batch; i++)
+        {
+            conns.push_back(File::dup(loopback.server.fd()));
+        }
+        double secs = bench::timeIt([&]() {
+            for (size_t i=0; i<total; i+=batch)
+            {
+                dispatcher.dispatch(conns);
+            }
+            char c;
+            done.reader().read(&c,1);
+        });
+        ::waitpid(pid,nullptr,0);
+        bench::report("FdDispatcher batch",batch,secs,total,0);
+    }
+    return 0;
+}
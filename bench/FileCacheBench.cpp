@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "File.h"
+#include "FileCache.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Constructing File(path) per request against FileCache::get, over a set of hot files
+// Usage: FileCacheBench [requests] [files]
+
+int main(int argc, char* argv[])
+{
+    size_t requests = (argc > 1) ? atol(argv[1]) : 1000000;
+    size_t numFiles = (argc > 2) ? atol(argv[2]) : 1000;
+
+    File dir = File::mkdir("filecache_bench.d",0755);
+    std::vector<std::string> paths;
+    for (size_t i=0; i<numFiles; i++)
+    {
+        paths.push_back("filecache_bench.d/f"+std::to_string(i));
+        File(paths.back(),O_WRONLY|O_CREAT|O_TRUNC,0644).write("x",1);
+    }
+
+    double secs = bench::timeIt([&]() {
+        for (size_t i=0; i<requests; i++)
+        {
+            File file(paths[i%numFiles]);
+        }
+    });
+    bench::report("File(path)",numFiles,secs,requests,0);
+
+    for (auto revalidate : {std::chrono::seconds(0),std::chrono::seconds(1)})
+    {
+        FileCache cache(numFiles,revalidate);
+        secs = bench::timeIt([&]() {
+            for (size_t i=0; i<requests; i++)
+            {
+                auto file = cache.get(paths[i%numFiles]);
+            }
+        });
+        bench::report(revalidate.count() ? "FileCache revalidate 1s" : "FileCache revalidate always",
+                      numFiles,secs,requests,0);
+    }
+
+    for (auto& path : paths)
+    {
+        File(path,O_RDONLY).remove();
+    }
+    dir.remove();
+    return 0;
+}
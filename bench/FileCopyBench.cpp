@@ -0,0 +1,50 @@
+#include <cstdlib>
+#include <vector>
+#include "File.h"
+#include "SharedFile.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Grow a std::vector of File / SharedFile from empty (reallocation moves), and copy it
+// Usage: FileCopyBench [files] [rounds]
+
+static const char* c_filename = "filecopy_bench.dat";
+
+template <typename Typ>
+static void run(const char* name, const Typ& proto, size_t count, size_t rounds)
+{
+    double secs = bench::timeIt([&]() {
+        for (size_t r=0; r<rounds; r++)
+        {
+            std::vector<Typ> vec;
+            vec.push_back(proto);
+            for (size_t i=1; i<count; i++)
+            {
+                vec.emplace_back(); // reallocation moves the elements
+            }
+        }
+    });
+    bench::report(std::string(name)+" grow",count,secs,rounds*count,0);
+
+    std::vector<Typ> source(count,proto);
+    secs = bench::timeIt([&]() {
+        for (size_t r=0; r<rounds; r++)
+        {
+            std::vector<Typ> copy(source);
+        }
+    });
+    bench::report(std::string(name)+" copy",count,secs,rounds*count,0);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 1000;
+    size_t rounds = (argc > 2) ? atol(argv[2]) : 1000;
+
+    File file(c_filename,O_RDWR|O_CREAT,0644);
+    run("File",file,count,rounds);
+    run("SharedFile",SharedFile(File(file)),count,rounds);
+    file.remove();
+    return 0;
+}
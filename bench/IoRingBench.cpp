@@ -0,0 +1,79 @@
+#include <vector>
+#include <cstdlib>
+#include "File.h"
+#include "IoRing.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Compare blocking File::read/write against batched IoRing reads/writes
+// Usage: IoRingBench [totalMB] [queueDepth]
+
+static const char* c_filename = "ioring_bench.dat";
+
+int main(int argc, char* argv[])
+{
+    size_t total = ((argc > 1) ? atol(argv[1]) : 64) << 20;
+    unsigned depth = (argc > 2) ? atoi(argv[2]) : 32;
+
+    File file(c_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    IoRing ring(depth);
+    ring.registerFiles({file.fd()});
+    std::vector<IoCompletion> cqes(depth);
+
+    for (size_t size : {size_t(4096),size_t(65536)})
+    {
+        size_t ops = total/size;
+        std::vector<char> buf(size*depth,'x');
+
+        double secs = bench::timeIt([&]() {
+            file.lseek(0);
+            for (size_t i=0; i<ops; i++)
+            {
+                file.write(&buf[0],size);
+            }
+        });
+        bench::report("File::write",size,secs,ops,total);
+
+        secs = bench::timeIt([&]() {
+            file.lseek(0);
+            for (size_t i=0; i<ops; i++)
+            {
+                file.read(&buf[0],size);
+            }
+        });
+        bench::report("File::read",size,secs,ops,total);
+
+        // Keep depth ops in flight, one io_uring_enter per batch. file is registered as FixedFile{0}
+        auto runRing = [&](bool isWrite) {
+            size_t queued = 0;
+            size_t done = 0;
+            while (done < ops)
+            {
+                while (queued < ops and queued-done < depth)
+                {
+                    char* ptr = &buf[(queued%depth)*size];
+                    if (isWrite)
+                    {
+                        ring.prepWrite(FixedFile{0},ptr,size,queued*size,queued);
+                    }
+                    else
+                    {
+                        ring.prepRead(FixedFile{0},ptr,size,queued*size,queued);
+                    }
+                    queued++;
+                }
+                ring.submitAndWait(1);
+                done += ring.reap(&cqes[0],cqes.size());
+            }
+        };
+
+        secs = bench::timeIt([&]() {runRing(true);});
+        bench::report("IoRing write",size,secs,ops,total);
+
+        secs = bench::timeIt([&]() {runRing(false);});
+        bench::report("IoRing read",size,secs,ops,total);
+    }
+    file.unlink();
+    return 0;
+}
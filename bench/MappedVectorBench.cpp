@@ -0,0 +1,58 @@
+#include <vector>
+#include <cstdlib>
+#include "File.h"
+#include "MappedVector.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Append N small structs: std::vector plus one final write, against MappedVector
+// Usage: MappedVectorBench [millions]
+
+struct Record
+{
+    uint64_t id;
+    uint32_t key;
+    uint32_t value;
+};
+
+static const char* c_filename = "mappedvector_bench.dat";
+
+int main(int argc, char* argv[])
+{
+    size_t count = ((argc > 1) ? atol(argv[1]) : 100)*1000000UL;
+    size_t bytes = count*sizeof(Record);
+
+    double secs = bench::timeIt([&]() {
+        std::vector<Record> vec;
+        for (size_t i=0; i<count; i++)
+        {
+            vec.push_back(Record{i,uint32_t(i),uint32_t(~i)});
+        }
+        File file(c_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+        file.write(vec.data(),bytes);
+    });
+    bench::report("std::vector+write",sizeof(Record),secs,count,bytes);
+    File(c_filename,O_RDONLY).remove();
+
+    secs = bench::timeIt([&]() {
+        MappedVector<Record> vec(c_filename);
+        for (size_t i=0; i<count; i++)
+        {
+            vec.push_back(Record{i,uint32_t(i),uint32_t(~i)});
+        }
+    });
+    bench::report("MappedVector::push_back",sizeof(Record),secs,count,bytes);
+    File(c_filename,O_RDONLY).remove();
+
+    secs = bench::timeIt([&]() {
+        MappedVector<Record> vec(c_filename,count);
+        for (size_t i=0; i<count; i++)
+        {
+            vec.push_back(Record{i,uint32_t(i),uint32_t(~i)});
+        }
+    });
+    bench::report("MappedVector reserved",sizeof(Record),secs,count,bytes);
+    File(c_filename,O_RDONLY).remove();
+    return 0;
+}
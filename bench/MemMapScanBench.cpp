@@ -0,0 +1,81 @@
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include "File.h"
+#include "MemMap.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Time-to-first-full-scan of a file mapping, with and without prefaulting
+// "cold" runs drop the file from the page cache first with POSIX_FADV_DONTNEED
+// Usage: MemMapScanBench [fileMB]
+
+static const char* c_filename = "memmap_bench.dat";
+
+// Sum every 64-bit word so each page is touched
+static uint64_t scan(const MemMap<uint64_t>& map)
+{
+    uint64_t sum = 0;
+    const uint64_t* ptr = map.get();
+    for (size_t i=0; i<map.len(); i++)
+    {
+        sum += ptr[i];
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t size = ((argc > 1) ? atol(argv[1]) : 1024) << 20;
+
+    File file(c_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    std::vector<char> chunk(1<<20,1);
+    for (size_t n=0; n<size; n+=chunk.size())
+    {
+        file.write(&chunk[0],chunk.size());
+    }
+    file.fsync();
+
+    struct Case
+    {
+        const char* name;
+        MmapFlags flags;
+        bool prefault;
+        bool sequential;
+        bool cold;
+    };
+    const Case cases[] = {
+        {"cold, fault on access",MAP_SHARED_,false,false,true},
+        {"cold, MADV_SEQUENTIAL",MAP_SHARED_,false,true,true},
+        {"cold, MAP_POPULATE",MAP_SHARED_|MAP_POPULATE_,false,false,true},
+        {"cold, prefault()",MAP_SHARED_,true,false,true},
+        {"warm, fault on access",MAP_SHARED_,false,false,false},
+        {"warm, MAP_POPULATE",MAP_SHARED_|MAP_POPULATE_,false,false,false},
+        {"warm, prefault()",MAP_SHARED_,true,false,false},
+    };
+
+    uint64_t sum = 0;
+    for (const auto& c : cases)
+    {
+        if (c.cold)
+        {
+            file.fadvise(0,0,POSIX_FADV_DONTNEED);
+        }
+        double secs = bench::timeIt([&]() {
+            MemMap<uint64_t> map(file,size,0,c.flags,PROT_READ_);
+            if (c.sequential)
+            {
+                map.advise(MADV_SEQUENTIAL_);
+            }
+            if (c.prefault)
+            {
+                map.prefault();
+            }
+            sum += scan(map);
+        });
+        bench::report(c.name,size,secs,1,size);
+    }
+    file.unlink();
+    return sum == 0;
+}
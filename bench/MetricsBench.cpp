@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <cstdlib>
+#include "Metrics.h"
+#include "Pipe.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Cost of the metrics on a 1 byte pipe write+read, recording on and off.
+// Build with make metrics=1 to measure the instrumented wrappers
+// Usage: MetricsBench [iterations]
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 1000000;
+    printf("metrics %s\n",Metrics::compiledIn() ? "compiled in" : "not compiled in");
+
+    Pipe pipe;
+    char c = 'x';
+    for (bool on : {false,true})
+    {
+        Metrics::enable(on);
+        double secs = bench::timeIt([&]() {
+            for (size_t i=0; i<count; i++)
+            {
+                pipe.writer().write(&c,1);
+                pipe.reader().read(&c,1);
+            }
+        });
+        bench::report(on ? "pipe write+read, recording" : "pipe write+read, not recording",1,secs,count,count);
+    }
+
+    double secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i++)
+        {
+            Metrics::record(Metrics::FILE_READ,Metrics::start(),1);
+        }
+    });
+    bench::report("Metrics::record",1,secs,count,0);
+    printf("%s\n",Metrics::snapshot().toJson().c_str());
+    return 0;
+}
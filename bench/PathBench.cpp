@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "File.h"
+#include "Path.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Path normalization: the old stringstream implementation against Path
+// Usage: PathBench [iterations]
+
+// The stringstream based File::normalizePath that Path replaced
+static std::string legacyNormalizePath(const std::string& path)
+{
+    if (path.empty())
+    {
+        return "";
+    }
+    std::istringstream iss(path);
+    std::ostringstream oss;
+    while (iss)
+    {
+        std::string tok;
+        if (iss.eof())
+        {
+            break;
+        }
+        getline(iss,tok,'/');
+        if (oss.str().empty())
+        {
+            if (tok.empty())
+            {
+                oss << "/";
+            }
+            else if (tok == ".")
+            {
+                oss << ".";
+            }
+            else
+            {
+                oss << "./" << tok;
+            }
+        }
+        else if (tok.empty())
+        {
+            continue;
+        }
+        else
+        {
+            if (oss.str().back()!='/')
+            {
+                oss << '/';
+            }
+            oss << tok;
+        }
+    }
+    return oss.str();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 1000000;
+    const std::vector<std::string> paths{
+        "/srv/www/static/assets/v2/images/icons/24x24/user-profile-avatar.png",
+        "/var/lib/postgresql/15/main/base/16384/2619_fsm",
+        "data//tenants/acme/2024/06/17/events-000123.parquet/",
+        "/home/builder/src/project/build/release/lib/libfoo.so.1.2.3",
+        "/proc/self/fd/7",
+    };
+    size_t bytes = 0;
+    for (auto& path : paths)
+    {
+        bytes += path.size();
+    }
+
+    size_t sink = 0;
+    double secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i++)
+        {
+            for (auto& path : paths)
+            {
+                sink += legacyNormalizePath(path).size();
+            }
+        }
+    });
+    bench::report("stringstream normalizePath",paths.size(),secs,count*paths.size(),count*bytes);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i++)
+        {
+            for (auto& path : paths)
+            {
+                sink += File::normalizePath(path).size();
+            }
+        }
+    });
+    bench::report("File::normalizePath",paths.size(),secs,count*paths.size(),count*bytes);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i++)
+        {
+            for (auto& path : paths)
+            {
+                sink += Path(path).size();
+            }
+        }
+    });
+    bench::report("Path",paths.size(),secs,count*paths.size(),count*bytes);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i++)
+        {
+            for (auto& path : paths)
+            {
+                sink += Path(path).parent().size();
+            }
+        }
+    });
+    bench::report("Path+parent",paths.size(),secs,count*paths.size(),count*bytes);
+    return sink == 0;
+}
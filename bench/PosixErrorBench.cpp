@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <string>
+#include "File.h"
+#include "Pipe.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Per-call cost of the error checks on the success path: 1-byte write and
+// read through a pipe with raw syscalls, with File::write/read, and with
+// raw syscalls checked by the old style of ASSERT taking a std::string
+// Usage: PosixErrorBench [iterations]
+
+// The check as it was: out of line, building a std::string from the literal every call
+__attribute__((noinline)) static void oldAssert(bool truth, const std::string& msg)
+{
+    if (not truth)
+    {
+        throw PosixError(msg);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = (argc > 1) ? atol(argv[1]) : 1000000;
+    Pipe pipe;
+    const File& reader = pipe.reader();
+    const File& writer = pipe.writer();
+    char c = 'x';
+
+    double secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            if (::write(writer.fd(),&c,1) != 1 or ::read(reader.fd(),&c,1) != 1)
+            {
+                abort();
+            }
+        }
+    });
+    bench::report("raw write+read",1,secs,iterations,iterations);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            oldAssert(::write(writer.fd(),&c,1) != -1,"write");
+            oldAssert(::read(reader.fd(),&c,1) != -1,"read");
+        }
+    });
+    bench::report("raw + std::string ASSERT",1,secs,iterations,iterations);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            PosixError::ASSERT(::write(writer.fd(),&c,1) != -1,"write");
+            PosixError::ASSERT(::read(reader.fd(),&c,1) != -1,"read");
+        }
+    });
+    bench::report("raw + PosixError::ASSERT",1,secs,iterations,iterations);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            writer.write(&c,1);
+            reader.read(static_cast<void*>(&c),1);
+        }
+    });
+    bench::report("File::write+read",1,secs,iterations,iterations);
+
+    // Cost of a throw, catch and what()
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations/10; i++)
+        {
+            try
+            {
+                PosixError::ASSERT(false,"fail");
+            }
+            catch (const PosixError& e)
+            {
+                c = e.what()[0];
+            }
+        }
+    });
+    bench::report("throw+catch+what",1,secs,iterations/10,0);
+    return 0;
+}
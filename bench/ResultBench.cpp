@@ -0,0 +1,70 @@
+#include <fcntl.h>
+#include <cstdlib>
+#include "File.h"
+#include "Pipe.h"
+#include "Socket.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Reads that would block, in a loop: the throwing calls caught per EAGAIN
+// against the noexcept tryXyz() calls returning a Result
+// Usage: ResultBench [iterations]
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = (argc > 1) ? atol(argv[1]) : 200000;
+    char buf[64];
+
+    Pipe pipe;
+    ::fcntl(pipe.reader().fd(),F_SETFL,O_NONBLOCK);
+    size_t blocked = 0;
+    double secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            try
+            {
+                pipe.reader().read(static_cast<void*>(buf),sizeof(buf));
+            }
+            catch (const PosixError& e)
+            {
+                blocked += e.errnoVal() == EAGAIN;
+            }
+        }
+    });
+    bench::report("pipe read, catch EAGAIN",sizeof(buf),secs,iterations,0);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            blocked += pipe.reader().tryRead(buf,sizeof(buf)).wouldBlock();
+        }
+    });
+    bench::report("pipe tryRead",sizeof(buf),secs,iterations,0);
+
+    Socket socket(AF_INET,SOCK_DGRAM);
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            try
+            {
+                socket.recv(buf,sizeof(buf),MSG_DONTWAIT);
+            }
+            catch (const PosixError& e)
+            {
+                blocked += e.errnoVal() == EAGAIN;
+            }
+        }
+    });
+    bench::report("udp recv, catch EAGAIN",sizeof(buf),secs,iterations,0);
+
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<iterations; i++)
+        {
+            blocked += socket.tryRecv(buf,sizeof(buf),MSG_DONTWAIT).wouldBlock();
+        }
+    });
+    bench::report("udp tryRecv",sizeof(buf),secs,iterations,0);
+
+    return blocked == 4*iterations ? 0 : 1;
+}
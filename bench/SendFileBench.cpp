@@ -0,0 +1,72 @@
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include "File.h"
+#include "Socket.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Compare File::read + Socket::write against Socket::sendFile over loopback TCP
+// Usage: SendFileBench [fileMB] [passes]
+
+static const char* c_filename = "sendfile_bench.dat";
+
+int main(int argc, char* argv[])
+{
+    size_t size = ((argc > 1) ? atol(argv[1]) : 256) << 20;
+    unsigned passes = (argc > 2) ? atoi(argv[2]) : 4;
+
+    File file(c_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    std::vector<char> buf(0x10000,'x');
+    for (size_t n=0; n<size; n+=buf.size())
+    {
+        file.write(&buf[0],buf.size());
+    }
+
+    bench::Loopback loop;
+    size_t total = size*passes;
+
+    // Drain the server side so the sender never stalls on us
+    std::thread sink([&loop,total]() {
+        std::vector<char> rbuf(0x40000);
+        size_t got = 0;
+        while (got < 2*total)
+        {
+            ssize_t n = loop.server.read(&rbuf[0],rbuf.size());
+            if (n <= 0)
+            {
+                break;
+            }
+            got += n;
+        }
+    });
+
+    double secs = bench::timeIt([&]() {
+        for (unsigned p=0; p<passes; p++)
+        {
+            file.lseek(0);
+            ssize_t n;
+            while ((n = file.read(&buf[0],buf.size())) > 0)
+            {
+                for (ssize_t off=0; off<n; )
+                {
+                    off += loop.client->write(&buf[off],n-off);
+                }
+            }
+        }
+    });
+    bench::report("read/write loop",buf.size(),secs,total/buf.size(),total);
+
+    secs = bench::timeIt([&]() {
+        for (unsigned p=0; p<passes; p++)
+        {
+            loop.client->sendFile(file,0,size);
+        }
+    });
+    bench::report("Socket::sendFile",size,secs,passes,total);
+
+    sink.join();
+    file.unlink();
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <functional>
+#include "File.h"
+#include "Pipe.h"
+#include "SocketPair.h"
+#include "SharedQueue.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Ping-pong a 64 bit counter between two processes: shared-memory queues against Pipe and SocketPair
+// Usage: SharedQueueBench [roundTrips]
+
+// Fork a child running echo(), time ping() in the parent and report the round trip rate
+static void pingPong(const char* name, size_t count, std::function<void()> echo, std::function<void()> ping)
+{
+    pid_t pid = ::fork();
+    PosixError::ASSERT(pid!=-1,"fork");
+    if (pid == 0)
+    {
+        echo();
+        _exit(0);
+    }
+    double secs = bench::timeIt(ping);
+    ::waitpid(pid,nullptr,0);
+    bench::report(name,sizeof(uint64_t),secs,count,2*count*sizeof(uint64_t));
+    printf("%-32s %8.2f us/round trip\n","",secs/count*1e6);
+}
+
+template <typename Queue>
+static void queuePingPong(const char* name, size_t count)
+{
+    File pingShm = File::memfd_create("ping");
+    File pongShm = File::memfd_create("pong");
+    Queue ping(pingShm,64);
+    Queue pong(pongShm,64);
+    pingPong(name,count,
+        [&]() {
+            uint64_t value = 0;
+            for (size_t i=0; i<count; i++)
+            {
+                ping.popWait(value);
+                pong.push(value+1);
+            }
+        },
+        [&]() {
+            uint64_t value = 0;
+            for (size_t i=0; i<count; i++)
+            {
+                ping.push(value);
+                pong.popWait(value);
+            }
+        });
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 100000;
+
+    queuePingPong<SpscQueue<uint64_t>>("SpscQueue",count);
+    queuePingPong<MpscQueue<uint64_t>>("MpscQueue",count);
+
+    Pipe toChild;
+    Pipe toParent;
+    pingPong("Pipe",count,
+        [&]() {
+            uint64_t value;
+            for (size_t i=0; i<count; i++)
+            {
+                toChild.reader().read(&value,sizeof(value));
+                value++;
+                toParent.writer().write(&value,sizeof(value));
+            }
+        },
+        [&]() {
+            uint64_t value = 0;
+            for (size_t i=0; i<count; i++)
+            {
+                toChild.writer().write(&value,sizeof(value));
+                toParent.reader().read(&value,sizeof(value));
+            }
+        });
+
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    pingPong("SocketPair",count,
+        [&]() {
+            uint64_t value;
+            for (size_t i=0; i<count; i++)
+            {
+                pair.reader().read(&value,sizeof(value));
+                value++;
+                pair.reader().write(&value,sizeof(value));
+            }
+        },
+        [&]() {
+            uint64_t value = 0;
+            for (size_t i=0; i<count; i++)
+            {
+                pair.writer().write(&value,sizeof(value));
+                pair.writer().read(&value,sizeof(value));
+            }
+        });
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "File.h"
+#include "IoRing.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Metadata for every file in a directory: stat(2) by full path, statxAt() with
+// a narrow mask, and the same statx calls batched through an IoRing
+// Usage: StatxBench [files]
+
+static const std::string c_root = "statx_bench.d";
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 10000;
+
+    File::mkdir(c_root,0755);
+    std::vector<std::string> names;
+    for (size_t i=0; i<count; i++)
+    {
+        names.push_back("f"+std::to_string(i));
+        File(c_root+"/"+names.back(),O_WRONLY|O_CREAT,0644);
+    }
+    File dir(c_root,O_RDONLY|O_DIRECTORY);
+
+    uint64_t total = 0;
+    double secs = bench::timeIt([&]() {
+        for (auto& name : names)
+        {
+            total += File::lstat(c_root+"/"+name).st_size;
+        }
+    });
+    bench::report("lstat per path",count,secs,count,0);
+
+    secs = bench::timeIt([&]() {
+        for (auto& stx : dir.statxAt(names,STATX_SIZE))
+        {
+            total += stx->stx_size;
+        }
+    });
+    bench::report("statxAt STATX_SIZE",count,secs,count,0);
+
+    const unsigned batch = 64;
+    IoRing ring(batch);
+    std::vector<struct statx> out(batch);
+    std::vector<IoCompletion> completions(batch);
+    secs = bench::timeIt([&]() {
+        for (size_t i=0; i<count; i+=batch)
+        {
+            unsigned n = std::min<size_t>(batch,count-i);
+            for (unsigned j=0; j<n; j++)
+            {
+                ring.prepStatx(dir,names[i+j].c_str(),AT_SYMLINK_NOFOLLOW,STATX_SIZE,&out[j],j);
+            }
+            ring.submitAndWait(n);
+            for (unsigned reaped=0; reaped<n; )
+            {
+                reaped += ring.reap(&completions[reaped],n-reaped);
+            }
+            for (unsigned j=0; j<n; j++)
+            {
+                total += out[j].stx_size;
+            }
+        }
+    });
+    bench::report("IoRing statx batch="+std::to_string(batch),count,secs,count,0);
+
+    ::system(("rm -rf "+c_root).c_str());
+    return total == 0 ? 0 : 1;
+}
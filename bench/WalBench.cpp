@@ -0,0 +1,78 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "File.h"
+#include "WriteAheadLog.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Durable commits per second against the number of concurrent writers:
+// write+fdatasync per transaction on a shared file, against WriteAheadLog group commit
+// Usage: WalBench [seconds] [recordBytes]
+
+static const std::string c_dir = "wal_bench.d";
+
+// Run fn on writers threads until secs have passed, returns the total calls
+template <typename Fn>
+static uint64_t runFor(unsigned writers, double secs, Fn&& fn)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> total(0);
+    std::vector<std::thread> threads;
+    for (unsigned i=0; i<writers; i++)
+    {
+        threads.emplace_back([&]() {
+            uint64_t n = 0;
+            while (not stop.load(std::memory_order_relaxed))
+            {
+                fn();
+                n++;
+            }
+            total += n;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+    stop = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return total;
+}
+
+int main(int argc, char* argv[])
+{
+    double secs = (argc > 1) ? atof(argv[1]) : 1.0;
+    size_t size = (argc > 2) ? atol(argv[2]) : 128;
+    std::string record(size,'w');
+
+    for (unsigned writers : {1U,2U,4U,8U,16U,32U})
+    {
+        ::system(("rm -rf "+c_dir+" && mkdir "+c_dir).c_str());
+        {
+            File file(c_dir+"/plain.log",O_WRONLY|O_CREAT|O_APPEND,0644);
+            std::mutex mutex;
+            uint64_t commits = runFor(writers,secs,[&]() {
+                // What each service did: write and sync under its own transaction
+                std::lock_guard<std::mutex> lock(mutex);
+                file.write(record);
+                file.fdatasync();
+            });
+            bench::report("write+fdatasync writers="+std::to_string(writers),size,secs,commits,commits*size);
+        }
+        ::system(("rm -rf "+c_dir).c_str());
+        {
+            WriteAheadLog wal(c_dir);
+            uint64_t commits = runFor(writers,secs,[&]() {wal.commit(record);});
+            bench::report("WriteAheadLog writers="+std::to_string(writers),size,secs,commits,commits*size);
+            printf("  commits per sync: %.1f\n",double(commits)/wal.syncs());
+        }
+    }
+    ::system(("rm -rf "+c_dir).c_str());
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "File.h"
+#include "StreamingWriter.h"
+#include "Bench.h"
+
+using namespace posixcpp;
+
+// Latency of each 1 MiB write streaming a large file (512 of them by default), then of the final sync:
+// plain File::write plus fsync, against StreamingWriter plus finish()
+// Usage: WriteBehindBench [fileMB]
+
+static const std::string c_filename = "writebehind_bench.dat";
+
+template <typename WriteFn, typename SyncFn>
+static void run(const std::string& name, size_t size, WriteFn&& writeFn, SyncFn&& syncFn)
+{
+    std::vector<char> block(1<<20,'w');
+    std::vector<double> latencies;
+    double secs = bench::timeIt([&]() {
+        for (size_t done=0; done<size; done+=block.size())
+        {
+            latencies.push_back(bench::timeIt([&]() {writeFn(block);}));
+        }
+    });
+    double syncSecs = bench::timeIt(syncFn);
+    std::sort(latencies.begin(),latencies.end());
+    bench::report(name,block.size(),secs+syncSecs,latencies.size(),size);
+    printf("  write p50 %.3f ms  p99 %.3f ms  max %.3f ms  final sync %.3f ms\n",
+           1e3*latencies[latencies.size()/2],1e3*latencies[latencies.size()*99/100],
+           1e3*latencies.back(),1e3*syncSecs);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t size = ((argc > 1) ? atol(argv[1]) : 512) << 20;
+    {
+        File file(c_filename,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        run("write+fsync",size,
+            [&](const std::vector<char>& block) {file.write(block);},
+            [&]() {file.fsync();});
+    }
+    {
+        File file(c_filename,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        StreamingWriter writer(file);
+        run("StreamingWriter",size,
+            [&](const std::vector<char>& block) {writer.write(block);},
+            [&]() {writer.finish();});
+    }
+    File(c_filename).remove();
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "AlignedBufferPool.h"
+#include "File.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class AlignedBufferPoolTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "direct.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(AlignedBufferPoolTester,basic)
+{
+    AlignedBufferPool pool(1000,2);
+    ASSERT_EQ(4096U,pool.bufferSize());
+    ASSERT_EQ(2U,pool.allocated());
+    ASSERT_EQ(2U,pool.available());
+
+    AlignedBuffer a = pool.acquire();
+    ASSERT_TRUE(a);
+    ASSERT_EQ(0U,reinterpret_cast<uintptr_t>(a.data())%4096);
+    ASSERT_EQ(4096U,a.size());
+    a.resize(512);
+    ASSERT_EQ(512U,a.size());
+    EXPECT_THROW(a.resize(4097),PosixError);
+    ASSERT_EQ(1U,pool.available());
+
+    // Reuse, no allocation until the pool runs dry
+    char* data = a.data();
+    a.release();
+    ASSERT_FALSE(a);
+    ASSERT_EQ(data,pool.acquire().data());
+    {
+        AlignedBuffer b = pool.acquire();
+        AlignedBuffer c = pool.acquire();
+        AlignedBuffer d = pool.acquire();
+        ASSERT_EQ(3U,pool.allocated());
+        c = std::move(d);
+        ASSERT_EQ(1U,pool.available());
+    }
+    ASSERT_EQ(3U,pool.available());
+    EXPECT_THROW(AlignedBufferPool(4096,0,1000),PosixError);
+}
+
+TEST_F(AlignedBufferPoolTester,direct)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC|O_DIRECT,0644);
+    ASSERT_TRUE(file.direct());
+    ASSERT_EQ(O_RDWR|O_DIRECT,file.mode());
+    ASSERT_GT(file.directMemAlign(),0U);
+    ASSERT_GT(file.directOffsetAlign(),0U);
+
+    AlignedBufferPool pool(8192,1,std::max<size_t>(file.directMemAlign(),sizeof(void*)));
+    AlignedBuffer buf = pool.acquire();
+    memset(buf.data(),'x',buf.size());
+    ASSERT_EQ(8192,file.write(buf));
+    ASSERT_EQ(4096,file.pwrite(buf.data(),4096,8192));
+    ASSERT_EQ(12288U,file.getSize(false));
+
+    // Through the read template, the length in use follows the bytes read
+    file.lseek(0);
+    buf.resize(0);
+    ASSERT_EQ(8192,file.read(buf,8192));
+    ASSERT_EQ('x',buf[8191]);
+    buf.resize(8192);
+    ASSERT_EQ(4096,file.pread(buf,8192));
+    ASSERT_EQ(4096U,buf.size());
+
+    // Off by one in each of address, length and offset
+    size_t align = file.directOffsetAlign();
+    if (file.directMemAlign() > 1)
+    {
+        EXPECT_THROW(file.pread(buf.data()+1,align,0),PosixError);
+    }
+    EXPECT_THROW(file.pread(buf.data(),align+1,0),PosixError);
+    try
+    {
+        file.pread(buf.data(),align,1);
+        FAIL() << "misaligned offset";
+    }
+    catch (const PosixError& e)
+    {
+        ASSERT_EQ(EINVAL,e.errnoVal());
+        ASSERT_NE(nullptr,strstr(e.what(),"offset"));
+    }
+
+    // The noexcept calls check the same alignment
+    ASSERT_EQ(EINVAL,file.tryPread(buf.data(),align+1,0).error().value());
+    ASSERT_EQ(EINVAL,file.tryPwrite(buf.data(),align,1).error().value());
+    ASSERT_EQ(ssize_t(align),file.tryPread(buf.data(),align,0).value());
+
+    // Buffered again, anything goes
+    file.setDirect(false);
+    ASSERT_FALSE(file.direct());
+    ASSERT_EQ(O_RDWR,file.mode());
+    ASSERT_EQ(3,file.pread(buf.data()+1,3,1));
+    file.setDirect(true);
+    ASSERT_TRUE(file.direct());
+
+    // The alignment moves with the fd
+    File moved;
+    moved = std::move(file);
+    ASSERT_TRUE(moved.direct());
+    ASSERT_EQ(align,moved.directOffsetAlign());
+    EXPECT_THROW(moved.pread(buf.data(),align+1,0),PosixError);
+    ASSERT_EQ(ssize_t(align),moved.pread(buf.data(),align,0));
+    moved = File(m_filename,O_RDONLY);
+    ASSERT_FALSE(moved.direct());
+    ASSERT_EQ(3,moved.pread(buf.data()+1,3,1));
+}
@@ -0,0 +1,166 @@
+#include <string>
+#include <vector>
+#include "BufferedFile.h"
+#include "Pipe.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class BufferedFileTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "buffered.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(BufferedFileTester,coalesce)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    {
+        BufferedFile out(file,64);
+        for (unsigned i=0; i<10; i++)
+        {
+            out.write("abcd",4);
+        }
+        ASSERT_EQ(0U,file.getSize(false)) << "nothing written before flush";
+        out.flush();
+        ASSERT_EQ(40U,file.getSize(false));
+
+        // Filling the buffer writes it out
+        for (unsigned i=0; i<20; i++)
+        {
+            out.write("abcd",4);
+        }
+        ASSERT_EQ(104U,file.getSize(false));
+
+        // Larger than the buffer goes straight through
+        std::string big(100,'b');
+        out.write(big);
+        ASSERT_EQ(220U,file.getSize(false)) << "flushes what was buffered first";
+        out.write("tail",4);
+    }
+    ASSERT_EQ(224U,file.getSize(false)) << "destructor flushes";
+}
+
+TEST_F(BufferedFileTester,readLine)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write(std::string("first\n\nthird line\nlast"));
+    file.lseek(0);
+
+    BufferedFile in(file,8);
+    std::vector<std::string> lines;
+    while (auto line = in.readLine())
+    {
+        lines.emplace_back(*line);
+    }
+    ASSERT_EQ(4U,lines.size());
+    ASSERT_EQ("first",lines[0]);
+    ASSERT_EQ("",lines[1]);
+    ASSERT_EQ("third line",lines[2]) << "longer than the buffer";
+    ASSERT_EQ("last",lines[3]);
+    ASSERT_FALSE(in.readLine());
+}
+
+TEST_F(BufferedFileTester,readUntil)
+{
+    Pipe pipe;
+    pipe.writer().write(std::string("a,bb,,ccc,"));
+    pipe.writer().close();
+    BufferedFile in(pipe.reader());
+    ASSERT_EQ("a",*in.readUntil(','));
+    ASSERT_EQ("bb",*in.readUntil(','));
+    ASSERT_EQ("",*in.readUntil(','));
+    ASSERT_EQ("ccc",*in.readUntil(','));
+    ASSERT_FALSE(in.readUntil(','));
+}
+
+TEST_F(BufferedFileTester,read)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    std::string data = "0123456789";
+    file.write(data);
+    file.lseek(0);
+
+    BufferedFile in(file,4);
+    char buf[16];
+    ASSERT_EQ(3,in.read(buf,3));
+    ASSERT_EQ("012",std::string(buf,3));
+    ASSERT_EQ(1,in.read(buf,3)) << "rest of the buffer";
+    ASSERT_EQ('3',buf[0]);
+    ASSERT_EQ(6,in.read(buf,sizeof(buf))) << "large read bypasses the buffer";
+    ASSERT_EQ(0,in.read(buf,sizeof(buf)));
+}
+
+TEST_F(BufferedFileTester,readThenWrite)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write(std::string("line1\nline2\n"));
+    file.lseek(0);
+
+    // The write lands after the record consumed, not after the read-ahead
+    BufferedFile bf(file);
+    ASSERT_EQ("line1",*bf.readLine());
+    bf.write("LINE2",5);
+    bf.flush();
+    std::string readback;
+    file.pread(readback,0,12);
+    ASSERT_EQ("line1\nLINE2\n",readback);
+}
+
+TEST_F(BufferedFileTester,rainyDay)
+{
+    File file(m_filename,O_RDWR|O_CREAT);
+    EXPECT_THROW(BufferedFile(file,0),PosixError);
+
+    File readOnly(m_filename,O_RDONLY);
+    BufferedFile out(readOnly);
+    out.write("x",1);
+    EXPECT_THROW(out.flush(),PosixError);
+}
+
+TEST_F(BufferedFileTester,flushRetry)
+{
+    Pipe pipe;
+    ::fcntl(pipe.writer().fd(),F_SETFL,O_NONBLOCK);
+    int capacity = pipe.setSize(4096);
+    std::string data(3*capacity,'\0');
+    for (size_t i=0; i<data.size(); i++)
+    {
+        data[i] = char('a'+i%26);
+    }
+
+    BufferedFile out(pipe.writer(),data.size()+1);
+    out.write(data);
+    std::string received;
+    std::vector<char> chunk(capacity);
+    int failures = 0;
+    while (true)
+    {
+        try
+        {
+            out.flush();
+            break;
+        }
+        catch (const PosixError& e)
+        {
+            // Full pipe: nothing buffered is lost, drain and retry
+            ASSERT_EQ(EAGAIN,e.errnoVal());
+            failures++;
+            ssize_t n = pipe.reader().read(static_cast<void*>(&chunk[0]),chunk.size());
+            received.append(&chunk[0],n);
+        }
+    }
+    ASSERT_GT(failures,0);
+    while (received.size() < data.size())
+    {
+        ssize_t n = pipe.reader().read(static_cast<void*>(&chunk[0]),chunk.size());
+        received.append(&chunk[0],n);
+    }
+    ASSERT_EQ(data,received);
+}
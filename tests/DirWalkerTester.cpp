@@ -0,0 +1,156 @@
+#include <sys/resource.h>
+#include <unistd.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include "DirWalker.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class DirWalkerTester : public ::testing::Test
+{
+public:
+    std::string m_root = "dirwalker.d";
+    std::set<std::string> m_expected;
+
+    // m_root/dN/fM for N<4, M<5, m_root/d0/sub/deep, and a symlink to m_root
+    void SetUp()
+    {
+        File::mkdir(m_root,0755);
+        for (unsigned d=0; d<4; d++)
+        {
+            std::string dir = m_root+"/d"+std::to_string(d);
+            File::mkdir(dir,0755);
+            m_expected.insert("./"+dir);
+            for (unsigned f=0; f<5; f++)
+            {
+                std::string file = dir+"/f"+std::to_string(f);
+                File(file,O_WRONLY|O_CREAT,0644);
+                m_expected.insert("./"+file);
+            }
+        }
+        File::mkdir(m_root+"/d0/sub",0755);
+        File(m_root+"/d0/sub/deep",O_WRONLY|O_CREAT,0644);
+        ::symlink("..",(m_root+"/link").c_str());
+        m_expected.insert("./"+m_root+"/d0/sub");
+        m_expected.insert("./"+m_root+"/d0/sub/deep");
+        m_expected.insert("./"+m_root+"/link");
+    }
+
+    void TearDown()
+    {
+        ::system(("rm -rf "+m_root).c_str());
+    }
+};
+
+TEST_F(DirWalkerTester,walk)
+{
+    for (unsigned threads : {1,3})
+    {
+        DirWalker walker(threads);
+        ASSERT_EQ(threads,walker.threads());
+        std::mutex mutex;
+        std::set<std::string> seen;
+        unsigned links = 0;
+        auto stats = walker.walk(m_root,[&](const DirWalker::Entry& entry) {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.insert(entry.path());
+            if (entry.name == "deep")
+            {
+                EXPECT_EQ(2U,entry.depth);
+                EXPECT_EQ(DT_REG,entry.type);
+            }
+            if (entry.type == DT_LNK)
+            {
+                links++;
+            }
+            return true;
+        });
+        ASSERT_EQ(m_expected,seen);
+        ASSERT_EQ(1U,links) << "symlinks are not followed";
+        ASSERT_EQ(m_expected.size(),stats.entries);
+        ASSERT_EQ(6U,stats.dirs);
+        ASSERT_EQ(0U,stats.errors);
+    }
+}
+
+TEST_F(DirWalkerTester,symlinkRoot)
+{
+    // A root that is a symlink to a directory is followed, unlike the links below it
+    std::string link = m_root+".lnk";
+    ASSERT_EQ(0,::symlink(m_root.c_str(),link.c_str()));
+    DirWalker walker(2);
+    uint64_t entries = 0;
+    ASSERT_NO_THROW(entries = walker.walk(link,[](const DirWalker::Entry&) {return true;}).entries);
+    ::unlink(link.c_str());
+    ASSERT_EQ(m_expected.size(),entries);
+}
+
+TEST_F(DirWalkerTester,prune)
+{
+    DirWalker walker(2);
+    std::atomic<unsigned> files{0};
+    auto stats = walker.walk(m_root,[&](const DirWalker::Entry& entry) {
+        if (entry.type == DT_REG)
+        {
+            auto stx = entry.statx(STATX_SIZE);
+            EXPECT_EQ(0U,stx.stx_size);
+            files++;
+        }
+        return entry.name != "d0";
+    });
+    ASSERT_EQ(15U,files.load()) << "d0 is skipped";
+    ASSERT_EQ(4U,stats.dirs);
+}
+
+TEST_F(DirWalkerTester,maxOpenDirs)
+{
+    // With a budget of one open directory the other tasks open by full path
+    DirWalker walker(2,64*1024,1);
+    std::mutex mutex;
+    std::set<std::string> seen;
+    auto stats = walker.walk(m_root,[&](const DirWalker::Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.insert(entry.path());
+        return true;
+    });
+    ASSERT_EQ(m_expected,seen);
+    ASSERT_EQ(6U,stats.dirs);
+    ASSERT_EQ(0U,stats.errors);
+}
+
+TEST_F(DirWalkerTester,outOfFds)
+{
+    // Leave room for the root only, the first subdirectory then fails with EMFILE
+    int lowest = ::dup(0);
+    ASSERT_NE(-1,lowest);
+    ::close(lowest);
+    struct rlimit old;
+    ASSERT_EQ(0,getrlimit(RLIMIT_NOFILE,&old));
+    struct rlimit limit = old;
+    limit.rlim_cur = lowest+1;
+    ASSERT_EQ(0,setrlimit(RLIMIT_NOFILE,&limit));
+
+    DirWalker walker(1,64*1024,16);
+    int err = 0;
+    try
+    {
+        walker.walk(m_root,[](const DirWalker::Entry&) {return true;});
+    }
+    catch (const PosixError& e)
+    {
+        err = e.errnoVal();
+    }
+    setrlimit(RLIMIT_NOFILE,&old);
+    ASSERT_EQ(EMFILE,err) << "not counted as an error";
+}
+
+TEST_F(DirWalkerTester,rainyDay)
+{
+    DirWalker walker(2);
+    EXPECT_THROW(walker.walk("no/such/dir",[](const DirWalker::Entry&) {return true;}),PosixError);
+    EXPECT_THROW(walker.walk(m_root,[](const DirWalker::Entry&) -> bool {throw std::runtime_error("stop");}),
+                 std::runtime_error);
+}
@@ -0,0 +1,132 @@
+#include <sys/stat.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileCache.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class FileCacheTester : public ::testing::Test
+{
+public:
+    std::vector<std::string> m_filenames{"cache0.dat","cache1.dat","cache2.dat"};
+
+    void SetUp()
+    {
+        for (auto& name : m_filenames)
+        {
+            File(name,O_WRONLY|O_CREAT|O_TRUNC,0644).write(name);
+        }
+    }
+
+    void TearDown()
+    {
+        for (auto& name : m_filenames)
+        {
+            File(name,O_RDONLY|O_CREAT).remove();
+        }
+    }
+};
+
+TEST_F(FileCacheTester,hits)
+{
+    FileCache cache;
+    auto file = cache.get(m_filenames[0]);
+    ASSERT_EQ(O_RDONLY,file->mode());
+    auto again = cache.get("./"+m_filenames[0]);
+    ASSERT_EQ(file,again) << "same normalized path, same handle";
+    ASSERT_EQ(1U,cache.size());
+
+    auto stats = cache.stats();
+    ASSERT_EQ(1U,stats.hits);
+    ASSERT_EQ(1U,stats.misses);
+    ASSERT_EQ(0U,stats.evictions);
+
+    std::string buf;
+    file->pread(buf,0,m_filenames[0].size());
+    ASSERT_EQ(m_filenames[0],buf);
+
+    cache.erase(m_filenames[0]);
+    ASSERT_EQ(0U,cache.size());
+    ASSERT_NE(file,cache.get(m_filenames[0]));
+}
+
+TEST_F(FileCacheTester,evict)
+{
+    FileCache cache(2);
+    auto file0 = cache.get(m_filenames[0]);
+    cache.get(m_filenames[1]);
+    cache.get(m_filenames[0]); // file1 is now least recently used
+    cache.get(m_filenames[2]);
+    ASSERT_EQ(2U,cache.size());
+    ASSERT_EQ(1U,cache.stats().evictions);
+    ASSERT_EQ(file0,cache.get(m_filenames[0])) << "still cached";
+    cache.get(m_filenames[1]);
+    ASSERT_EQ(4U,cache.stats().misses) << "file1 was evicted";
+    ASSERT_GE(file0->fd(),0) << "handles outlive eviction";
+}
+
+TEST_F(FileCacheTester,revalidate)
+{
+    FileCache cache(16,FileCache::clock_t::duration::zero());
+    auto old = cache.get(m_filenames[0]);
+
+    // Replace the file with a new inode
+    ASSERT_EQ(0,::rename(m_filenames[1].c_str(),m_filenames[0].c_str()));
+    auto replaced = cache.get(m_filenames[0]);
+    ASSERT_NE(old,replaced);
+    ASSERT_EQ(1U,cache.stats().invalidations);
+
+    // Same inode, new mtime
+    struct timespec times[2] = {{0,UTIME_OMIT},{12345,0}};
+    ASSERT_EQ(0,::utimensat(AT_FDCWD,m_filenames[0].c_str(),times,0));
+    ASSERT_NE(replaced,cache.get(m_filenames[0]));
+    ASSERT_EQ(2U,cache.stats().invalidations);
+
+    // Without revalidation the stale handle is returned
+    FileCache lazy(16,std::chrono::hours(1));
+    auto first = lazy.get(m_filenames[2]);
+    times[1].tv_sec = 54321;
+    ASSERT_EQ(0,::utimensat(AT_FDCWD,m_filenames[2].c_str(),times,0));
+    ASSERT_EQ(first,lazy.get(m_filenames[2]));
+
+    // Nor by default within a second
+    FileCache defaults;
+    first = defaults.get(m_filenames[2]);
+    times[1].tv_sec = 11111;
+    ASSERT_EQ(0,::utimensat(AT_FDCWD,m_filenames[2].c_str(),times,0));
+    ASSERT_EQ(first,defaults.get(m_filenames[2]));
+}
+
+TEST_F(FileCacheTester,threads)
+{
+    FileCache cache(2);
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<4; t++)
+    {
+        threads.emplace_back([this,&cache,t]() {
+            for (unsigned i=0; i<1000; i++)
+            {
+                auto file = cache.get(m_filenames[(i+t)%m_filenames.size()]);
+                ASSERT_GE(file->fd(),0);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto stats = cache.stats();
+    ASSERT_EQ(4000U,stats.hits+stats.misses);
+    ASSERT_LE(cache.size(),2U);
+}
+
+TEST_F(FileCacheTester,rainyDay)
+{
+    FileCache cache;
+    EXPECT_THROW(cache.get("no/such/file"),PosixError);
+    EXPECT_THROW(FileCache(0),PosixError);
+}
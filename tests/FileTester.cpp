@@ -1,6 +1,8 @@
 #include <fstream>
 #include <array>
 #include <functional>
+#include <thread>
+#include <atomic>
 #include "File.h"
 #include "PosixError.h"
 #include <gtest/gtest.h>
@@ -152,6 +154,29 @@ TEST_F(FileTester,fdatasync)
     EXPECT_NO_THROW(fileObj.fdatasync());
 }
 
+TEST_F(FileTester,readahead_fadvise)
+{
+    auto file = File(m_filename);
+    EXPECT_NO_THROW(file.readahead(0,c_fileSize));
+    for (auto advice : {POSIX_FADV_NORMAL,POSIX_FADV_SEQUENTIAL,POSIX_FADV_RANDOM,
+                        POSIX_FADV_NOREUSE,POSIX_FADV_WILLNEED,POSIX_FADV_DONTNEED})
+    {
+        EXPECT_NO_THROW(file.fadvise(0,0,advice)) << advice;
+    }
+
+    File pipeReader(readFd());
+    try
+    {
+        pipeReader.fadvise(0,0,POSIX_FADV_SEQUENTIAL);
+        FAIL() << "fadvise on a pipe";
+    }
+    catch (const PosixError& e)
+    {
+        ASSERT_EQ(ESPIPE,e.errnoVal());
+    }
+    EXPECT_THROW(pipeReader.readahead(0,1),PosixError);
+}
+
 TEST_F(FileTester,unlink)
 {
     auto file = File(m_filename);
@@ -374,6 +399,113 @@ TEST_F(FileTester,templates)
     ASSERT_EQ(0,n);
 }
 
+TEST_F(FileTester,readv_writev)
+{
+    std::string header = "HDR:";
+    std::string payload = "payload";
+    File file(m_filename,O_RDWR|O_TRUNC);
+    std::array<iovec,2> out{iovec{&header[0],header.size()},iovec{&payload[0],payload.size()}};
+    ASSERT_EQ(ssize_t(header.size()+payload.size()),file.writev(out));
+
+    file.lseek(0);
+    std::string hdr(header.size(),'\0');
+    std::string pay(payload.size(),'\0');
+    std::array<iovec,2> in{iovec{&hdr[0],hdr.size()},iovec{&pay[0],pay.size()}};
+    ASSERT_EQ(ssize_t(header.size()+payload.size()),file.readv(in));
+    ASSERT_EQ(header,hdr);
+    ASSERT_EQ(payload,pay);
+}
+
+TEST_F(FileTester,pread_pwrite)
+{
+    File file(m_filename,O_RDWR);
+    char cc;
+    ASSERT_EQ(1,file.pread(&cc,1,100));
+    ASSERT_EQ(char(100),cc);
+    ASSERT_EQ(0,file.lseek(0,SEEK_CUR)) << "pread must not move the offset";
+
+    cc = 'z';
+    ASSERT_EQ(1,file.pwrite(&cc,1,10));
+    ASSERT_EQ(0,file.lseek(0,SEEK_CUR)) << "pwrite must not move the offset";
+
+    std::array<uint8_t,4> buf;
+    std::array<iovec,1> iov{iovec{&buf[0],buf.size()}};
+    ASSERT_EQ(4,file.preadv2(iov,8));
+    ASSERT_EQ(8,buf[0]);
+    ASSERT_EQ('z',buf[2]);
+
+    // offset -1 reads at, and advances, the file offset
+    ASSERT_EQ(4,file.preadv2(iov,-1));
+    ASSERT_EQ(0,buf[0]);
+    ASSERT_EQ(4,file.lseek(0,SEEK_CUR));
+
+    ASSERT_EQ(4,file.pwritev2(iov,0,RWF_DSYNC));
+
+    File pipeReader(readFd());
+    EXPECT_THROW(pipeReader.pread(&cc,1,0),PosixError) << "cannot pread a pipe";
+}
+
+TEST_F(FileTester,preadv2_nowait)
+{
+    // RWF_NOWAIT on an empty pipe fails with EAGAIN rather than blocking
+    File reader(readFd());
+    char cc;
+    std::array<iovec,1> iov{iovec{&cc,1}};
+    try
+    {
+        reader.preadv2(iov,-1,RWF_NOWAIT);
+        FAIL() << "expected EAGAIN";
+    }
+    catch (const PosixError& e)
+    {
+        ASSERT_TRUE(e.errnoVal() == EAGAIN or e.errnoVal() == EOPNOTSUPP) << e.what();
+    }
+}
+
+TEST_F(FileTester,pread_concurrent)
+{
+    File file(m_filename,O_RDONLY);
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> errors{0};
+    for (unsigned t=0; t<4; t++)
+    {
+        threads.emplace_back([&file,&errors]() {
+            for (unsigned i=0; i<1000; i++)
+            {
+                uint8_t cc;
+                off_t offset = i%c_fileSize;
+                if (file.pread(&cc,1,offset) != 1 or cc != offset)
+                {
+                    errors++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(0U,errors);
+}
+
+TEST_F(FileTester,pread_templates)
+{
+    std::vector<double> writeData{1,2,3,4,5};
+    std::vector<double> readback;
+    File file(m_filename,O_RDWR|O_TRUNC);
+    ASSERT_EQ(ssize_t(writeData.size()),file.pwrite(writeData,8));
+    ASSERT_EQ(ssize_t(writeData.size()),file.pread(readback,8,writeData.size()));
+    ASSERT_EQ(writeData,readback);
+    ASSERT_EQ(0,file.pread(readback,1000,writeData.size()));
+    ASSERT_TRUE(readback.empty());
+
+    std::string msg = "Hello World";
+    file.pwrite(msg,0);
+    std::string response;
+    file.pread(response,0,5);
+    ASSERT_EQ("Hello",response);
+}
+
 TEST_F(FileTester,array)
 {
     ssize_t n;
@@ -578,3 +710,104 @@ TEST_F(FileTester,ostream2)
     n = oss.str().find("File");
     ASSERT_NE(std::string::npos,n) << file;
 }
+
+TEST(File,memfd_create)
+{
+    File file = File::memfd_create("test");
+    ASSERT_GE(file.fd(),0);
+    file.write("abc",3);
+    ASSERT_EQ(3U,file.getSize(false));
+}
+
+TEST(File,openat)
+{
+    File dir(std::string("."),O_RDONLY|O_DIRECTORY);
+    File file = dir.openat("openat.dat",O_RDWR|O_CREAT,0644);
+    ASSERT_EQ("./openat.dat",file.filename());
+    ASSERT_TRUE(file.exists());
+    file.remove();
+    EXPECT_THROW(dir.openat("no/such/file"),PosixError);
+}
+
+TEST(File,statx)
+{
+    File file = File::memfd_create("statx");
+    file.write("abcde",5);
+    struct statx stx = file.statx(STATX_SIZE);
+    ASSERT_TRUE(stx.stx_mask & STATX_SIZE);
+    ASSERT_EQ(5U,stx.stx_size);
+    // fstat is filled on first use, after the write
+    ASSERT_EQ(5,file.fstat().st_size);
+}
+
+TEST(File,statxAt)
+{
+    File dir(std::string("."),O_RDONLY|O_DIRECTORY);
+    File file = dir.openat("statxAt.dat",O_RDWR|O_CREAT,0644);
+    file.write("abc",3);
+    std::vector<std::string> names{"statxAt.dat","no-such-file"};
+    auto result = dir.statxAt(names,STATX_SIZE|STATX_TYPE);
+    ASSERT_EQ(2U,result.size());
+    ASSERT_TRUE(result[0].has_value());
+    ASSERT_EQ(3U,result[0]->stx_size);
+    ASSERT_TRUE(S_ISREG(result[0]->stx_mode));
+    ASSERT_FALSE(result[1].has_value());
+    file.remove();
+}
+
+TEST(File,is_mount)
+{
+    ASSERT_TRUE(File(std::string("/"),O_RDONLY|O_DIRECTORY).is_mount());
+    ASSERT_FALSE(File(std::string("/"),O_RDONLY|O_DIRECTORY).openat("etc",O_RDONLY|O_DIRECTORY).is_mount());
+    ASSERT_FALSE(File::memfd_create("mount").is_mount());
+}
+
+TEST(File,fallocate)
+{
+    File file = File::memfd_create("fallocate");
+    file.fallocate(0,8192);
+    ASSERT_EQ(8192U,file.getSize(false));
+
+    // Past the end without changing the size
+    file.fallocate(8192,8192,FALLOC_FL_KEEP_SIZE);
+    ASSERT_EQ(8192U,file.getSize(false));
+
+    std::string data(8192,'x');
+    file.pwrite(data,0);
+    file.fallocate(0,4096,FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE);
+    std::string readback(8192,'\0');
+    ASSERT_EQ(8192,file.pread(readback,0));
+    ASSERT_EQ(std::string(4096,'\0'),readback.substr(0,4096));
+    ASSERT_EQ(std::string(4096,'x'),readback.substr(4096));
+    EXPECT_THROW(file.fallocate(0,-1),PosixError);
+}
+
+TEST(File,syncRange)
+{
+    File dir(std::string("."),O_RDONLY|O_DIRECTORY);
+    File file = dir.openat("syncRange.dat",O_RDWR|O_CREAT|O_TRUNC,0644);
+    file.write(std::string(10000,'s'));
+    file.syncRange(0,0);
+    file.syncRange(0,4096,SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+    file.fadvise(0,0,POSIX_FADV_DONTNEED);
+    file.remove();
+    EXPECT_THROW(File().syncRange(0,0),PosixError);
+}
+
+TEST(File,concurrentFstat)
+{
+    // Const callers on one shared File fill the stat cache from several threads
+    const File file = File::memfd_create("concurrent");
+    std::vector<std::thread> threads;
+    std::atomic<int> regular(0);
+    for (int i=0; i<8; i++)
+    {
+        threads.emplace_back([&]() {regular += file.is_file();});
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(8,regular.load());
+    ASSERT_TRUE(S_ISREG(file.fstat().st_mode));
+}
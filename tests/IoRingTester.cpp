@@ -0,0 +1,203 @@
+#include <array>
+#include <string>
+#include <arpa/inet.h>
+#include "IoRing.h"
+#include "Loopback.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class IoRingTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "ioring.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(IoRingTester,basic)
+{
+    IoRing ring(8);
+    ASSERT_GE(ring.sqEntries(),8U);
+    ASSERT_GE(ring.cqEntries(),ring.sqEntries());
+    ASSERT_EQ(0U,ring.pending());
+    ASSERT_EQ(0U,ring.submit());
+
+    IoCompletion cqe;
+    ASSERT_EQ(0U,ring.reap(&cqe,1));
+}
+
+TEST_F(IoRingTester,readWrite)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    std::string msg = "Hello World";
+    IoRing ring;
+
+    // Two writes in one batch
+    ring.prepWrite(file,&msg[0],msg.size(),0,1);
+    ring.prepWrite(file,&msg[0],msg.size(),msg.size(),2);
+    ASSERT_EQ(2U,ring.pending());
+    ASSERT_EQ(2U,ring.submitAndWait(2));
+
+    std::array<IoCompletion,4> cqes;
+    ASSERT_EQ(2U,ring.reap(&cqes[0],cqes.size()));
+    for (unsigned i=0; i<2; i++)
+    {
+        ASSERT_EQ(int(msg.size()),cqes[i].res);
+    }
+    ASSERT_EQ(2*msg.size(),file.getSize(false));
+
+    ring.prepFsync(file,true,3);
+    auto cqe = ring.wait();
+    ASSERT_EQ(3U,cqe.userData);
+    ASSERT_EQ(0,cqe.res);
+
+    std::string readback(msg.size(),'\0');
+    ring.prepRead(file,&readback[0],readback.size(),msg.size(),4);
+    cqe = ring.wait();
+    ASSERT_EQ(4U,cqe.userData);
+    ASSERT_EQ(int(msg.size()),cqe.res);
+    ASSERT_EQ(msg,readback);
+}
+
+TEST_F(IoRingTester,errors)
+{
+    // Errors in an operation are reported in res, not thrown
+    File file(m_filename,O_RDONLY|O_CREAT);
+    IoRing ring;
+    char cc = 'a';
+    ring.prepWrite(file,&cc,1,0,7);
+    auto cqe = ring.wait();
+    ASSERT_EQ(7U,cqe.userData);
+    ASSERT_EQ(-EBADF,cqe.res);
+}
+
+TEST_F(IoRingTester,overflow)
+{
+    // Queueing more than sqEntries() submits the earlier ops automatically
+    File file("/dev/zero");
+    IoRing ring(4);
+    std::vector<char> buf(16);
+    unsigned n = 3*ring.sqEntries();
+    for (unsigned i=0; i<n; i++)
+    {
+        ring.prepRead(file,&buf[0],buf.size(),-1,i);
+    }
+    unsigned reaped = 0;
+    while (reaped < n)
+    {
+        auto cqe = ring.wait();
+        ASSERT_EQ(int(buf.size()),cqe.res);
+        reaped++;
+    }
+}
+
+TEST_F(IoRingTester,registered)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    std::vector<char> buf(4096,'x');
+    IoRing ring;
+    ring.registerFiles({file.fd()});
+    ring.registerBuffers({iovec{&buf[0],buf.size()}});
+
+    ring.prepWriteFixed(FixedFile{0},&buf[0],buf.size(),0,0,1);
+    auto cqe = ring.wait();
+    ASSERT_EQ(int(buf.size()),cqe.res);
+
+    std::fill(buf.begin(),buf.end(),0);
+    ring.prepReadFixed(FixedFile{0},&buf[0],buf.size(),0,0,2);
+    cqe = ring.wait();
+    ASSERT_EQ(int(buf.size()),cqe.res);
+    ASSERT_EQ('x',buf.back());
+
+    ring.prepFsync(FixedFile{0},true,3);
+    ASSERT_EQ(0,ring.wait().res);
+
+    ring.unregisterBuffers();
+    ring.unregisterFiles();
+}
+
+TEST_F(IoRingTester,registeredFdReused)
+{
+    // A registered fd is closed and its number reused, ops on the new File must reach the new file
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    IoRing ring;
+    ring.registerFiles({file.fd()});
+    int fd = file.fd();
+    file.close();
+    std::string other = m_filename+".other";
+    File reused(other,O_RDWR|O_CREAT|O_TRUNC);
+    ASSERT_EQ(fd,reused.fd());
+
+    std::string msg = "Hello World";
+    ring.prepWrite(reused,&msg[0],msg.size(),0,1);
+    ASSERT_EQ(int(msg.size()),ring.wait().res);
+    ASSERT_EQ(msg.size(),reused.getSize(false));
+    ASSERT_EQ(0U,File(m_filename,O_RDONLY).getSize(false));
+    reused.unlink();
+}
+
+TEST_F(IoRingTester,close)
+{
+    File file(m_filename,O_RDWR|O_CREAT);
+    int fd = file.fd();
+    IoRing ring;
+    ring.prepClose(file);
+    ASSERT_EQ(-1,file.fd());
+    ASSERT_EQ(0,ring.wait().res);
+    ASSERT_EQ(-1,::fcntl(fd,F_GETFL));
+}
+
+TEST_F(IoRingTester,statx)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write("abc",3);
+    File dir(std::string("."),O_RDONLY|O_DIRECTORY);
+    IoRing ring;
+    struct statx stx;
+    ring.prepStatx(dir,m_filename.c_str(),0,STATX_SIZE,&stx,1);
+    auto cqe = ring.wait();
+    ASSERT_EQ(1U,cqe.userData);
+    ASSERT_EQ(0,cqe.res);
+    ASSERT_EQ(3U,stx.stx_size);
+
+    ring.prepStatx(dir,"no-such-file",0,STATX_SIZE,&stx,2);
+    ASSERT_EQ(-ENOENT,ring.wait().res);
+}
+
+TEST_F(IoRingTester,socket)
+{
+    // Loopback listener on an ephemeral port
+    Socket listener(AF_INET,SOCK_STREAM);
+    sockaddr_in addr = bindLoopback(listener,1);
+
+    IoRing ring;
+    ring.prepAccept(listener,nullptr,nullptr,0,1);
+    ring.submit();
+
+    ClientSocket<AF_INET,SOCK_STREAM> client("127.0.0.1",ntohs(addr.sin_port));
+    client.connect();
+    auto cqe = ring.wait();
+    ASSERT_EQ(1U,cqe.userData);
+    ASSERT_GE(cqe.res,0);
+    File server(cqe.res,"accepted");
+
+    std::string msg = "Hello World";
+    ring.prepSend(client,&msg[0],msg.size(),0,2);
+    ASSERT_EQ(int(msg.size()),ring.wait().res);
+
+    std::string readback(msg.size(),'\0');
+    ring.prepRead(server,&readback[0],readback.size(),-1,3);
+    ASSERT_EQ(int(msg.size()),ring.wait().res);
+    ASSERT_EQ(msg,readback);
+
+    server.write(msg);
+    std::fill(readback.begin(),readback.end(),0);
+    ring.prepRecv(client,&readback[0],readback.size(),MSG_WAITALL,4);
+    ASSERT_EQ(int(msg.size()),ring.wait().res);
+    ASSERT_EQ(msg,readback);
+}
@@ -0,0 +1,52 @@
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <memory>
+#include "File.h"
+#include "PosixError.h"
+#include "Socket.h"
+
+// Loopback socket fixtures shared by the testers and the benchmark programs
+
+namespace posixcpp
+{
+
+// Bind sock to an ephemeral port on 127.0.0.1 and return its address. Listens too if backlog > 0
+inline sockaddr_in bindLoopback(const Socket& sock, int backlog=0)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof(addr);
+    PosixError::ASSERT(::bind(sock.fd(),(sockaddr*)&addr,sizeof(addr))==0,"bind");
+    if (backlog > 0)
+    {
+        PosixError::ASSERT(::listen(sock.fd(),backlog)==0,"listen");
+    }
+    PosixError::ASSERT(::getsockname(sock.fd(),(sockaddr*)&addr,&addrlen)==0,"getsockname");
+    return addr;
+}
+
+// A connected TCP pair over loopback
+struct Loopback
+{
+    Socket listener{AF_INET,SOCK_STREAM};
+    std::unique_ptr<ClientSocket<AF_INET,SOCK_STREAM>> client;
+    File server;
+
+    Loopback()
+    {
+        sockaddr_in addr = bindLoopback(listener,1);
+        client.reset(new ClientSocket<AF_INET,SOCK_STREAM>("127.0.0.1",ntohs(addr.sin_port)));
+        client->connect();
+        int fd = ::accept(listener.fd(),nullptr,nullptr);
+        PosixError::ASSERT(fd!=-1,"accept");
+        server = File(fd,"accepted");
+    }
+};
+
+}
+
+#endif
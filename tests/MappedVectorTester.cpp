@@ -0,0 +1,126 @@
+#include <string>
+#include "MappedVector.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+struct Point
+{
+    int32_t x;
+    int32_t y;
+    Point() = default;
+    Point(int32_t x_, int32_t y_) : x(x_), y(y_) {};
+};
+
+class MappedVectorTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "mappedvector.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(MappedVectorTester,grow)
+{
+    MappedVector<Point> vec(m_filename);
+    ASSERT_TRUE(vec.empty());
+    size_t initial = vec.capacity();
+    ASSERT_GT(initial,0U);
+
+    for (int i=0; i<10000; i++)
+    {
+        vec.push_back(Point(i,-i));
+    }
+    ASSERT_EQ(10000U,vec.size());
+    ASSERT_GE(vec.capacity(),10000U);
+    ASSERT_EQ(9999,vec.back().x);
+
+    Point& p = vec.emplace_back(7,8);
+    ASSERT_EQ(7,p.x);
+    ASSERT_EQ(10001U,vec.size());
+
+    int sum = 0;
+    for (const Point& pt : vec)
+    {
+        sum += pt.x+pt.y;
+    }
+    ASSERT_EQ(15,sum);
+    ASSERT_GE(vec.file().getSize(false),vec.capacity()*sizeof(Point));
+}
+
+TEST_F(MappedVectorTester,pushOwnElement)
+{
+    // Growing moves the mapping, the value must be taken before that
+    MappedVector<Point> vec(m_filename);
+    vec.push_back(Point(7,-7));
+    while (vec.size() < vec.capacity())
+    {
+        vec.push_back(Point(0,0));
+    }
+    for (int i=0; i<3; i++)
+    {
+        size_t cap = vec.capacity();
+        while (vec.size() < cap)
+        {
+            vec.push_back(Point(0,0));
+        }
+        vec.push_back(vec[0]);
+        ASSERT_GT(vec.capacity(),cap);
+        ASSERT_EQ(7,vec.back().x);
+        ASSERT_EQ(-7,vec.back().y);
+    }
+}
+
+TEST_F(MappedVectorTester,reserveAndShrink)
+{
+    MappedVector<uint64_t> vec(m_filename);
+    vec.reserve(100000);
+    ASSERT_GE(vec.capacity(),100000U);
+    vec.resize(10);
+    ASSERT_EQ(10U,vec.size());
+    ASSERT_EQ(0U,vec[9]);
+    vec.shrink_to_fit();
+    ASSERT_EQ(10U,vec.capacity());
+    vec.pop_back();
+    ASSERT_EQ(9U,vec.size());
+    vec.clear();
+    ASSERT_TRUE(vec.empty());
+}
+
+TEST_F(MappedVectorTester,reopen)
+{
+    {
+        MappedVector<Point> vec(m_filename);
+        for (int i=0; i<5000; i++)
+        {
+            vec.emplace_back(i,i*2);
+        }
+        vec.sync();
+    }
+    MappedVector<Point> vec(m_filename);
+    ASSERT_EQ(5000U,vec.size());
+    for (int i=0; i<5000; i++)
+    {
+        ASSERT_EQ(i,vec[i].x);
+        ASSERT_EQ(i*2,vec[i].y);
+    }
+    vec.push_back(Point(-1,-1));
+    ASSERT_EQ(5001U,vec.size());
+}
+
+TEST_F(MappedVectorTester,rainyDay)
+{
+    {
+        MappedVector<Point> vec(m_filename);
+        vec.emplace_back(1,2);
+    }
+    EXPECT_THROW(MappedVector<char> vec(m_filename),PosixError) << "element size mismatch";
+
+    File file(m_filename,O_RDWR|O_TRUNC);
+    file.write("garbage",7);
+    EXPECT_THROW(MappedVector<Point> vec(m_filename),PosixError) << "too small";
+}
@@ -58,3 +58,84 @@ TEST(MemMap,rainy)
     ASSERT_EQ(ENODEV,errno);
 }
 
+
+TEST(MemMap,hugePages)
+{
+    // Huge pages are usually not reserved, so this may fall back. Either way it must map.
+    File file;
+    auto flags = MmapFlags(MAP_PRIVATE_|MAP_ANONYMOUS_);
+    size_t sizeBytes = 3*getpagesize();
+    for (auto pageSize : {PAGE_DEFAULT,PAGE_TRANSPARENT_HUGE,PAGE_HUGE_2MB,PAGE_HUGE_1GB})
+    {
+        MemMap<char> map(file,sizeBytes,0,flags,PROT_RW_,pageSize);
+        ASSERT_EQ(sizeBytes,map.sizeBytes());
+        ASSERT_GE(map.mappedBytes(),sizeBytes);
+        ASSERT_EQ(0U,map.mappedBytes()%map.pageSize()) << "length rounded to the page size";
+        ASSERT_EQ((sizeBytes+map.pageSize()-1)/map.pageSize(),map.numPages());
+        if (map.pageSize() > size_t(getpagesize()))
+        {
+            ASSERT_EQ(0U,uintptr_t(map.get())%map.pageSize()) << "aligned to the huge page size";
+            ASSERT_EQ(1U,map.numPages());
+        }
+        memset(map.get(),'h',map.mappedBytes());
+    }
+    ASSERT_EQ(size_t(1)<<21,pageSizeBytes(PAGE_HUGE_2MB));
+    ASSERT_EQ(size_t(1)<<30,pageSizeBytes(PAGE_HUGE_1GB));
+    ASSERT_EQ(size_t(getpagesize()),pageSizeBytes(PAGE_DEFAULT));
+}
+
+TEST(MemMap,hugePagesFile)
+{
+    // A regular file cannot use MAP_HUGETLB, falls back to normal pages
+    File file("/dev/zero",O_RDWR);
+    MemMap<char> map(file,0x10000,0,MAP_SHARED_,PROT_RW_,PAGE_HUGE_2MB);
+    ASSERT_EQ(size_t(getpagesize()),map.pageSize());
+    ASSERT_EQ(0x10000/getpagesize(),int(map.numPages()));
+}
+
+TEST(MemMap,prefault)
+{
+    File file;
+    size_t sizeBytes = 0x100000;
+    MemMap<char> lazy(file,sizeBytes,0,MAP_PRIVATE_|MAP_ANONYMOUS_);
+    ASSERT_EQ(0.0,mincore(lazy.get(),sizeBytes)) << "nothing faulted in yet";
+    lazy.prefault(true);
+    ASSERT_EQ(1.0,mincore(lazy.get(),sizeBytes));
+
+    MemMap<char> populated(file,sizeBytes,0,MAP_PRIVATE_|MAP_ANONYMOUS_|MAP_POPULATE_);
+    ASSERT_EQ(1.0,mincore(populated.get(),sizeBytes));
+    // A write prefault of a read-only mapping only reads
+    File ro = File::memfd_create("prefault");
+    ro.ftruncate(sizeBytes);
+    MemMap<char> readOnly(ro,sizeBytes,0,MAP_SHARED_,PROT_READ_);
+    ASSERT_NO_THROW(readOnly.prefault(true));
+    ASSERT_EQ(1.0,mincore(readOnly.get(),sizeBytes));
+}
+
+TEST(MemMap,advise)
+{
+    File file;
+    size_t sizeBytes = 0x100000;
+    MemMap<char> map(file,sizeBytes,0,MAP_PRIVATE_|MAP_ANONYMOUS_);
+    memset(map.get(),'a',sizeBytes);
+    for (auto advice : {MADV_NORMAL_,MADV_SEQUENTIAL_,MADV_RANDOM_,MADV_WILLNEED_})
+    {
+        EXPECT_NO_THROW(map.advise(advice)) << advice;
+    }
+
+    // Unaligned ranges are widened to whole pages
+    EXPECT_NO_THROW(map.advise(MADV_WILLNEED_,100,10));
+
+    // DONTNEED on private anonymous memory gives back zero pages
+    map.advise(MADV_DONTNEED_,0,sizeBytes/2);
+    ASSERT_EQ(0,map.get()[0]);
+    ASSERT_EQ('a',map.get()[sizeBytes-1]);
+    EXPECT_NO_THROW(map.advise(MADV_FREE_));
+
+    EXPECT_THROW(memAdvise(map.get(),sizeBytes,MmapAdvice(-1)),PosixError);
+
+    // Ranges past the end are rejected rather than wrapping around
+    EXPECT_NO_THROW(map.advise(MADV_NORMAL_,sizeBytes-1,1));
+    EXPECT_THROW(map.advise(MADV_NORMAL_,sizeBytes+1),PosixError);
+    EXPECT_THROW(map.advise(MADV_NORMAL_,sizeBytes/2,sizeBytes),PosixError);
+}
@@ -0,0 +1,86 @@
+#include <string>
+#include <thread>
+#include "Metrics.h"
+#include "Pipe.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+TEST(Metrics,buckets)
+{
+    for (unsigned i=0; i<Metrics::NUM_BUCKETS; i++)
+    {
+        uint64_t lower = Metrics::bucketLowerBound(i);
+        ASSERT_EQ(i,Metrics::bucketIndex(lower)) << lower;
+        if (i > 0)
+        {
+            ASSERT_EQ(i-1,Metrics::bucketIndex(lower-1)) << lower;
+        }
+    }
+    ASSERT_EQ(0U,Metrics::bucketIndex(0));
+    ASSERT_EQ(Metrics::NUM_BUCKETS-1,Metrics::bucketIndex(~0ULL));
+}
+
+TEST(Metrics,record)
+{
+    auto before = Metrics::snapshot();
+    for (unsigned i=0; i<99; i++)
+    {
+        Metrics::recordNs(Metrics::FILE_FSYNC,1000,0);
+    }
+    Metrics::recordNs(Metrics::FILE_FSYNC,1000000,-1);
+
+    // A thread's counts survive the thread
+    std::thread([]() {Metrics::recordNs(Metrics::FILE_FSYNC,10,4096);}).join();
+
+    auto after = Metrics::snapshot();
+    const auto& op = after.ops[Metrics::FILE_FSYNC];
+    ASSERT_EQ("file_fsync",op.name);
+    ASSERT_EQ(101U,op.calls-before.ops[Metrics::FILE_FSYNC].calls);
+    ASSERT_EQ(1U,op.errors-before.ops[Metrics::FILE_FSYNC].errors);
+    ASSERT_EQ(4096U,op.bytes-before.ops[Metrics::FILE_FSYNC].bytes);
+
+    if (before.ops[Metrics::FILE_FSYNC].calls == 0)
+    {
+        // Quantiles are bucket upper bounds, within 1/8 of the value
+        ASSERT_NEAR(1000.0,double(op.quantileNs(0.5)),1000/8);
+        ASSERT_NEAR(1000000.0,double(op.quantileNs(1.0)),1000000/8);
+        ASSERT_LT(op.quantileNs(0.001),16U);
+    }
+
+    std::string json = after.toJson();
+    ASSERT_NE(std::string::npos,json.find("\"file_fsync\":{\"calls\":"));
+    std::string prom = after.toPrometheus();
+    ASSERT_NE(std::string::npos,prom.find("# TYPE posixcpp_latency_seconds histogram"));
+    ASSERT_NE(std::string::npos,prom.find("posixcpp_latency_seconds_bucket{op=\"file_fsync\",le=\"+Inf\"} "+std::to_string(op.calls)));
+
+    // Every bucket of every op is emitted, empty or not, plus +Inf
+    size_t buckets = 0;
+    std::string fsyncBucket = "posixcpp_latency_seconds_bucket{op=\"file_fsync\"";
+    for (size_t pos=prom.find(fsyncBucket); pos!=std::string::npos; pos=prom.find(fsyncBucket,pos+1))
+    {
+        buckets++;
+    }
+    ASSERT_EQ(size_t(Metrics::NUM_BUCKETS),buckets);
+}
+
+TEST(Metrics,wrappers)
+{
+    if (not Metrics::compiledIn())
+    {
+        GTEST_SKIP() << "built without POSIXCPP_METRICS";
+    }
+    Pipe pipe;
+    auto before = Metrics::snapshot();
+    pipe.writer().write("abc",3);
+    char buf[3];
+    pipe.reader().read(static_cast<void*>(buf),3);
+
+    Metrics::enable(false);
+    pipe.writer().write("abc",3);
+    Metrics::enable(true);
+
+    auto after = Metrics::snapshot();
+    ASSERT_EQ(1U,after.ops[Metrics::FILE_WRITE].calls-before.ops[Metrics::FILE_WRITE].calls);
+    ASSERT_EQ(3U,after.ops[Metrics::FILE_READ].bytes-before.ops[Metrics::FILE_READ].bytes);
+}
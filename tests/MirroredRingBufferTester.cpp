@@ -0,0 +1,99 @@
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include "MirroredRingBuffer.h"
+#include "Pipe.h"
+#include "SocketPair.h"
+#include "Loopback.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+TEST(MirroredRingBuffer,mirror)
+{
+    MirroredRingBuffer ring(1);
+    size_t cap = ring.capacity();
+    ASSERT_EQ(size_t(getpagesize()),cap);
+    ASSERT_TRUE(ring.empty());
+    ASSERT_EQ(cap,ring.writable().size());
+
+    // Move the tail close to the end so the next record wraps
+    ring.commit(cap-10);
+    ring.consume(cap-10);
+    ASSERT_TRUE(ring.empty());
+
+    std::string record(100,'x');
+    record.back() = '!';
+    auto out = ring.writable();
+    ASSERT_EQ(cap,out.size()) << "free space is contiguous across the wrap";
+    memcpy(out.data(),record.data(),record.size());
+    ring.commit(record.size());
+
+    auto in = ring.readable();
+    ASSERT_EQ(record,std::string(in.data(),in.size()));
+    ring.consume(in.size());
+    ASSERT_TRUE(ring.empty());
+
+    ring.commit(cap);
+    ASSERT_TRUE(ring.full());
+    ASSERT_EQ(0U,ring.writable().size());
+    EXPECT_THROW(ring.commit(1),PosixError);
+    EXPECT_THROW(ring.consume(cap+1),PosixError);
+}
+
+TEST(MirroredRingBuffer,pipe)
+{
+    MirroredRingBuffer ring(4096);
+    Pipe pipe;
+    std::string msg = "Hello World";
+    for (unsigned i=0; i<1000; i++)
+    {
+        pipe.writer().write(msg);
+        ASSERT_EQ(ssize_t(msg.size()),ring.readFrom(pipe.reader()));
+        auto in = ring.readable();
+        ASSERT_EQ(msg,std::string(in.data(),in.size()));
+        ring.consume(in.size());
+    }
+}
+
+TEST(MirroredRingBuffer,socketPair)
+{
+    MirroredRingBuffer ring(8192);
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    std::string msg(3000,'s');
+
+    ring.commit(ring.capacity()-1000);
+    ring.consume(ring.capacity()-1000);
+    pair.writer().write(msg);
+    ASSERT_EQ(ssize_t(msg.size()),ring.readFrom(pair.reader()));
+
+    // Echo it back through the other end
+    ASSERT_EQ(ssize_t(msg.size()),ring.writeTo(pair.reader()));
+    ASSERT_TRUE(ring.empty());
+    std::string echo;
+    ASSERT_EQ(ssize_t(msg.size()),pair.writer().read(echo,msg.size()));
+    ASSERT_EQ(msg,echo);
+
+    ::fcntl(pair.reader().fd(),F_SETFL,O_NONBLOCK);
+    ASSERT_EQ(-1,ring.readFrom(pair.reader())) << "would block";
+}
+
+TEST(MirroredRingBuffer,socket)
+{
+    MirroredRingBuffer ring(4096);
+    Socket sock(AF_INET,SOCK_DGRAM);
+    sockaddr_in addr = bindLoopback(sock);
+    PosixError::ASSERT(::connect(sock.fd(),(sockaddr*)&addr,sizeof(addr))==0,"connect");
+
+    std::string msg = "datagram";
+    memcpy(ring.writable().data(),msg.data(),msg.size());
+    ring.commit(msg.size());
+    ASSERT_EQ(ssize_t(msg.size()),ring.sendTo(sock));
+    ASSERT_TRUE(ring.empty());
+    ASSERT_EQ(ssize_t(msg.size()),ring.recvFrom(sock));
+    ASSERT_EQ(msg,std::string(ring.readable().data(),ring.size()));
+    ASSERT_EQ(-1,ring.recvFrom(sock,MSG_DONTWAIT)) << "would block";
+}
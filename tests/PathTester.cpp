@@ -0,0 +1,140 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Path.h"
+#include "File.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+// The stringstream based File::normalizePath that Path replaced
+static std::string legacyNormalizePath(const std::string& path)
+{
+    if (path.empty())
+    {
+        return "";
+    }
+    std::istringstream iss(path);
+    std::ostringstream oss;
+    while (iss)
+    {
+        std::string tok;
+        if (iss.eof())
+        {
+            break;
+        }
+        getline(iss,tok,'/');
+        if (oss.str().empty())
+        {
+            if (tok.empty())
+            {
+                oss << "/";
+            }
+            else if (tok == ".")
+            {
+                oss << ".";
+            }
+            else
+            {
+                oss << "./" << tok;
+            }
+        }
+        else if (tok.empty())
+        {
+            continue;
+        }
+        else
+        {
+            if (oss.str().back()!='/')
+            {
+                oss << '/';
+            }
+            oss << tok;
+        }
+    }
+    return oss.str();
+}
+
+TEST(Path,matchesLegacy)
+{
+    // Every string of up to 6 characters from this alphabet
+    const char alphabet[] = {'/','.','a'};
+    std::vector<std::string> inputs{""};
+    for (size_t i=0; i<inputs.size(); i++)
+    {
+        if (inputs[i].size() < 6)
+        {
+            for (char c : alphabet)
+            {
+                inputs.push_back(inputs[i]+c);
+            }
+        }
+    }
+    for (auto& input : inputs)
+    {
+        ASSERT_EQ(legacyNormalizePath(input),Path(input).str()) << '"' << input << '"';
+    }
+}
+
+TEST(Path,components)
+{
+    Path path("//usr//local/./lib/");
+    ASSERT_EQ("/usr/local/./lib",path);
+    ASSERT_TRUE(path.isAbsolute());
+    std::vector<std::string_view> parts(path.components().begin(),path.components().end());
+    ASSERT_EQ((std::vector<std::string_view>{"usr","local",".","lib"}),parts);
+    ASSERT_EQ("lib",path.basename());
+
+    Path relative("a/b");
+    ASSERT_FALSE(relative.isAbsolute());
+    parts.assign(relative.components().begin(),relative.components().end());
+    ASSERT_EQ((std::vector<std::string_view>{".","a","b"}),parts);
+
+    ASSERT_EQ(Path("/").components().begin(),Path("/").components().end());
+    ASSERT_EQ("",Path("/").basename());
+}
+
+TEST(Path,parent)
+{
+    Path path("/a/b/c");
+    ASSERT_EQ("/a/b",path.parentView());
+    ASSERT_EQ("/a",path.parent().parent());
+    ASSERT_EQ("/",path.parent().parent().parent());
+    ASSERT_EQ("/",Path("/").parent());
+    ASSERT_EQ(".",Path("x").parent());
+    ASSERT_FALSE(Path(".").hasParent());
+    ASSERT_FALSE(Path("").hasParent());
+}
+
+TEST(Path,long)
+{
+    std::string input;
+    while (input.size() < 3*Path::INLINE_SIZE)
+    {
+        input += "/component";
+    }
+    Path path(input);
+    ASSERT_EQ(input,path.str());
+    ASSERT_EQ(input.size(),path.parentView().size()+10);
+
+    Path copy(path);
+    ASSERT_EQ(path,copy);
+    Path moved(std::move(copy));
+    ASSERT_EQ(path,moved);
+    ASSERT_TRUE(copy.empty());
+
+    Path small("a/b");
+    small = moved;
+    ASSERT_EQ(path,small);
+    small = Path("c");
+    ASSERT_EQ("./c",small);
+}
+
+TEST(Path,file)
+{
+    File dir(std::string("."),O_RDONLY);
+    ASSERT_EQ(".",dir.path());
+    File root(Path("//"),O_RDONLY);
+    ASSERT_TRUE(root.is_mount());
+    ASSERT_EQ("/",root.parent().path());
+}
@@ -1,5 +1,9 @@
 #include <array>
 #include <list>
+#include <string>
+#include <thread>
+#include <csignal>
+#include <pthread.h>
 #include "Pipe.h"
 #include "PosixError.h"
 #include <gtest/gtest.h>
@@ -61,3 +65,100 @@ TEST_F(PipeTester,rainyDay)
     }
 }
 
+class PipeSpliceTester : public PipeTester
+{
+protected:
+    std::string m_filename = "splice.dat";
+    std::string m_message = "Hello World";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(PipeSpliceTester,splice)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write(m_message);
+
+    Pipe pipe;
+    loff_t offset = 6;
+    ASSERT_EQ(5,pipe.spliceFrom(file.fd(),100,&offset));
+    ASSERT_EQ(11,offset);
+
+    File out(m_filename+".out",O_RDWR|O_CREAT|O_TRUNC);
+    ASSERT_EQ(5,pipe.spliceTo(out.fd(),5));
+    std::string readback;
+    out.pread(readback,0,5);
+    ASSERT_EQ("World",readback);
+    out.remove();
+}
+
+TEST_F(PipeSpliceTester,nonblocking)
+{
+    // Empty nonblocking splice returns -1 instead of throwing
+    Pipe pipe;
+    File out(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    ASSERT_EQ(-1,pipe.spliceTo(out.fd(),5,nullptr,SPLICE_F_NONBLOCK));
+    EXPECT_THROW(pipe.spliceFrom(-1,5),PosixError);
+}
+
+TEST_F(PipeSpliceTester,interrupted)
+{
+    // A signal handler without SA_RESTART makes the blocked splice fail with EINTR
+    struct sigaction action{};
+    struct sigaction old;
+    action.sa_handler = [](int) {};
+    ASSERT_EQ(0,sigaction(SIGUSR1,&action,&old));
+
+    Pipe pipe;
+    Pipe out;
+    pthread_t self = pthread_self();
+    std::thread writer([&]() {
+        usleep(50000);
+        pthread_kill(self,SIGUSR1);
+        usleep(50000);
+        pipe.writer().write(m_message);
+    });
+    ssize_t moved = 0;
+    EXPECT_NO_THROW(moved = pipe.spliceTo(out.writer().fd(),m_message.size()));
+    writer.join();
+    sigaction(SIGUSR1,&old,nullptr);
+    ASSERT_EQ(ssize_t(m_message.size()),moved);
+}
+
+TEST_F(PipeSpliceTester,tee)
+{
+    Pipe pipe;
+    Pipe copy;
+    pipe.writer().write(m_message);
+    ASSERT_EQ(ssize_t(m_message.size()),pipe.tee(copy,100));
+
+    // Both pipes now hold the message
+    std::string a;
+    std::string b;
+    pipe.reader().read(a,m_message.size());
+    copy.reader().read(b,m_message.size());
+    ASSERT_EQ(m_message,a);
+    ASSERT_EQ(m_message,b);
+}
+
+TEST_F(PipeSpliceTester,vmsplice)
+{
+    Pipe pipe;
+    std::array<iovec,2> iov{iovec{&m_message[0],5},iovec{&m_message[5],6}};
+    ASSERT_EQ(ssize_t(m_message.size()),pipe.vmsplice(iov));
+    std::string readback;
+    pipe.reader().read(readback,m_message.size());
+    ASSERT_EQ(m_message,readback);
+}
+
+TEST_F(PipeSpliceTester,size)
+{
+    Pipe pipe;
+    ASSERT_GT(pipe.size(),0);
+    ASSERT_EQ(0x40000,pipe.setSize(0x40000));
+    ASSERT_EQ(0x40000,pipe.size());
+    EXPECT_THROW(pipe.setSize(0x7fffffff),PosixError);
+}
@@ -1,3 +1,6 @@
+#include <cstring>
+#include <thread>
+#include <vector>
 #include "File.h"
 #include "PosixError.h"
 #include <gtest/gtest.h>
@@ -26,3 +29,61 @@ TEST(PosixError,ASSERT)
 {
     EXPECT_THROW(PosixError::ASSERT(false),PosixError);
 }
+
+TEST(PosixError,what)
+{
+    // The text shows the error's own errno, not whatever errno is when it is formatted
+    PosixError e("context",EACCES);
+    errno = ENOENT;
+    std::string what = e.what();
+    ASSERT_NE(std::string::npos,what.find("errno="+std::to_string(EACCES)+",")) << what;
+    ASSERT_NE(std::string::npos,what.find(strerror(EACCES))) << what;
+    ASSERT_NE(std::string::npos,what.find("context")) << what;
+    ASSERT_EQ(e.what(),e.what());
+
+    // Copies format on their own
+    PosixError copy(e);
+    ASSERT_EQ(what,copy.what());
+}
+
+TEST(PosixError,ASSERTmessage)
+{
+    errno = EBADF;
+    try
+    {
+        PosixError::ASSERT(false,"literal");
+        FAIL() << "no throw";
+    }
+    catch (const PosixError& e)
+    {
+        ASSERT_EQ(EBADF,e.errnoVal());
+        ASSERT_NE(nullptr,strstr(e.what(),"literal"));
+    }
+    errno = EBADF;
+    EXPECT_THROW(PosixError::ASSERT(false,std::string("string")),PosixError);
+    PosixError::ASSERT(true,"not thrown");
+}
+
+TEST(PosixError,sharedWhat)
+{
+    // One exception_ptr rethrown and printed from several threads
+    std::exception_ptr ptr = std::make_exception_ptr(PosixError("shared",EIO));
+    std::vector<std::thread> threads;
+    for (unsigned i=0; i<4; i++)
+    {
+        threads.emplace_back([ptr]() {
+            try
+            {
+                std::rethrow_exception(ptr);
+            }
+            catch (const PosixError& e)
+            {
+                ASSERT_NE(nullptr,strstr(e.what(),"shared"));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
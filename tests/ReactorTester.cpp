@@ -0,0 +1,162 @@
+#include <array>
+#include <thread>
+#include "Reactor.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+TEST(Reactor,pipe)
+{
+    Reactor reactor;
+    Pipe pipe;
+    std::array<char,12> message{"Hello World"};
+    std::array<char,12> response{};
+    unsigned calls = 0;
+
+    reactor.add(pipe,Reactor::READABLE,[&](int fd, uint32_t events) {
+        ASSERT_EQ(pipe.reader().fd(),fd);
+        ASSERT_TRUE(events & Reactor::READABLE);
+        pipe.reader().readArray(response);
+        calls++;
+    });
+    ASSERT_TRUE(reactor.watching(pipe.reader().fd()));
+
+    ASSERT_EQ(0U,reactor.runOnce(0)) << "nothing to read yet";
+    pipe.writer().write(message);
+    ASSERT_EQ(1U,reactor.runOnce(1000));
+    ASSERT_EQ(1U,calls);
+    ASSERT_EQ(message,response);
+
+    // Edge triggered - no new data, no new event
+    ASSERT_EQ(0U,reactor.runOnce(0));
+}
+
+TEST(Reactor,closed)
+{
+    Reactor reactor;
+    Pipe pipe;
+    uint32_t seen = 0;
+    reactor.add(pipe.reader(),Reactor::READABLE,[&](int fd, uint32_t events) {
+        seen = events;
+    });
+    pipe.writer().close();
+    ASSERT_EQ(1U,reactor.runOnce(1000));
+    ASSERT_TRUE(seen & Reactor::CLOSED);
+}
+
+TEST(Reactor,socketPair)
+{
+    Reactor reactor;
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    unsigned writable = 0;
+    unsigned readable = 0;
+
+    reactor.add(pair.writer(),Reactor::WRITABLE,[&](int fd, uint32_t events) {
+        writable++;
+        // Switch to reads once we have written
+        reactor.modify(fd,Reactor::READABLE);
+        pair.writer().write("ping",4);
+    });
+    reactor.add(pair,Reactor::READABLE,[&](int fd, uint32_t events) {
+        std::array<char,4> buf;
+        pair.reader().readArray(buf);
+        readable++;
+    });
+
+    while (readable == 0)
+    {
+        reactor.runOnce(1000);
+    }
+    ASSERT_EQ(1U,writable);
+    ASSERT_EQ(1U,readable);
+}
+
+TEST(Reactor,remove)
+{
+    Reactor reactor;
+    Pipe pipe1;
+    Pipe pipe2;
+    unsigned calls = 0;
+
+    // Each callback removes both fds, so only one of them may run
+    auto callback = [&](int fd, uint32_t events) {
+        calls++;
+        reactor.remove(pipe1.reader().fd());
+        reactor.remove(pipe2.reader().fd());
+    };
+    reactor.add(pipe1,Reactor::READABLE,callback);
+    reactor.add(pipe2,Reactor::READABLE,callback);
+    pipe1.writer().write("a",1);
+    pipe2.writer().write("b",1);
+    reactor.runOnce(1000);
+    ASSERT_EQ(1U,calls);
+    ASSERT_FALSE(reactor.watching(pipe1.reader().fd()));
+    ASSERT_NO_THROW(reactor.remove(pipe1.reader().fd()));
+    EXPECT_THROW(reactor.modify(pipe1.reader().fd(),Reactor::READABLE),PosixError);
+}
+
+TEST(Reactor,replaced)
+{
+    Reactor reactor;
+    Pipe pipe1;
+    Pipe pipe2;
+    unsigned oldCalls = 0;
+    unsigned newCalls = 0;
+
+    // Whichever runs first replaces the other's handler, whose pending event is then skipped
+    auto replace = [&](int fd, uint32_t events) {
+        oldCalls++;
+        int other = (fd == pipe1.reader().fd()) ? pipe2.reader().fd() : pipe1.reader().fd();
+        reactor.remove(other);
+        reactor.add(other,Reactor::READABLE,[&](int fd, uint32_t events) {newCalls++;});
+    };
+    reactor.add(pipe1,Reactor::READABLE,replace);
+    reactor.add(pipe2,Reactor::READABLE,replace);
+    pipe1.writer().write("a",1);
+    pipe2.writer().write("b",1);
+    reactor.runOnce(1000);
+    ASSERT_EQ(1U,oldCalls);
+    ASSERT_EQ(0U,newCalls);
+}
+
+TEST(Reactor,throwingCallback)
+{
+    Reactor reactor;
+    Pipe pipe;
+    unsigned calls = 0;
+    reactor.add(pipe,Reactor::READABLE,[&](int fd, uint32_t events) {
+        char c;
+        pipe.reader().read(&c,1);
+        if (++calls == 1)
+        {
+            throw PosixError("callback",EIO);
+        }
+    });
+    pipe.writer().write("a",1);
+    EXPECT_THROW(reactor.runOnce(1000),PosixError);
+
+    // The handler is still in place for the next event
+    pipe.writer().write("b",1);
+    ASSERT_EQ(1U,reactor.runOnce(1000));
+    ASSERT_EQ(2U,calls);
+}
+
+TEST(Reactor,rainyDay)
+{
+    Reactor reactor;
+    File file;
+    EXPECT_THROW(reactor.add(file,Reactor::READABLE,nullptr),PosixError);
+
+    Pipe pipe;
+    reactor.add(pipe,Reactor::READABLE,nullptr);
+    EXPECT_THROW(reactor.add(pipe,Reactor::READABLE,nullptr),PosixError) << "already added";
+}
+
+TEST(Reactor,stop)
+{
+    Reactor reactor;
+    std::thread thread([&reactor]() {reactor.run(0);});
+    reactor.stop();
+    thread.join();
+}
@@ -0,0 +1,65 @@
+#include <array>
+#include <string>
+#include "Relay.h"
+#include "SocketPair.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class RelayTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "relay.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(RelayTester,fileToSocket)
+{
+    std::string msg(100000,'r');
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write(msg);
+    file.lseek(0);
+
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    Relay relay(file,pair.writer());
+    ASSERT_GT(relay.pipeSize(),0U);
+    ASSERT_EQ(msg.size(),relay.run());
+    ASSERT_TRUE(relay.eof());
+    ASSERT_EQ(0U,relay.buffered());
+
+    std::string readback;
+    size_t got = 0;
+    while (got < msg.size())
+    {
+        std::string chunk;
+        got += pair.reader().read(chunk,msg.size()-got);
+        readback += chunk;
+    }
+    ASSERT_EQ(msg,readback);
+}
+
+TEST_F(RelayTester,nonblocking)
+{
+    // Source has nothing yet - transfer returns without blocking
+    SocketPair in(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK);
+    SocketPair out(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK);
+    Relay relay(in.reader(),out.writer(),0x10000);
+    ASSERT_EQ(0U,relay.transfer(100));
+    ASSERT_FALSE(relay.eof());
+
+    std::string msg = "Hello World";
+    in.writer().write(msg);
+    ASSERT_EQ(msg.size(),relay.transfer(100));
+    std::array<char,11> readback;
+    out.reader().readArray(readback);
+    ASSERT_EQ(msg,std::string(readback.begin(),readback.end()));
+
+    in.writer().close();
+    ASSERT_EQ(0U,relay.transfer(100));
+    ASSERT_TRUE(relay.eof());
+}
@@ -0,0 +1,102 @@
+#include <fcntl.h>
+#include <string>
+#include "Result.h"
+#include "File.h"
+#include "MemMap.h"
+#include "Pipe.h"
+#include "Socket.h"
+#include "SocketPair.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+TEST(Result,basic)
+{
+    Result<int> ok(42);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(ok.has_value());
+    ASSERT_EQ(42,ok.value());
+    ASSERT_EQ(42,*ok);
+    ASSERT_FALSE(ok.error());
+
+    errno = ENOENT;
+    auto failed = Result<int>::lastError();
+    ASSERT_FALSE(failed);
+    ASSERT_EQ(std::errc::no_such_file_or_directory,failed.error());
+    ASSERT_FALSE(failed.wouldBlock());
+    ASSERT_EQ(7,failed.value_or(7));
+    try
+    {
+        failed.value();
+        FAIL() << "value() of an error";
+    }
+    catch (const PosixError& e)
+    {
+        ASSERT_EQ(ENOENT,e.errnoVal());
+        ASSERT_EQ(failed.error(),e.code());
+    }
+}
+
+TEST(Result,file)
+{
+    Pipe pipe;
+    ::fcntl(pipe.reader().fd(),F_SETFL,O_NONBLOCK);
+    char buf[16];
+    auto r = pipe.reader().tryRead(buf,sizeof(buf));
+    ASSERT_FALSE(r);
+    ASSERT_TRUE(r.wouldBlock());
+    ASSERT_EQ(std::errc::resource_unavailable_try_again,r.error());
+
+    ASSERT_EQ(3,pipe.writer().tryWrite("abc",3).value());
+    r = pipe.reader().tryRead(buf,sizeof(buf));
+    ASSERT_TRUE(r);
+    ASSERT_EQ(3,*r);
+
+    // Bad fds report EBADF instead of throwing
+    File closed;
+    ASSERT_EQ(EBADF,closed.tryWrite("abc",3).error().value());
+    ASSERT_EQ(EBADF,closed.tryPread(buf,1,0).error().value());
+
+    File mem = File::memfd_create("result");
+    ASSERT_EQ(3,*mem.tryPwrite("xyz",3,10));
+    ASSERT_EQ(1,*mem.tryPread(buf,1,11));
+    ASSERT_EQ('y',buf[0]);
+}
+
+TEST(Result,pipe)
+{
+    Pipe from;
+    Pipe to;
+    ::fcntl(from.reader().fd(),F_SETFL,O_NONBLOCK);
+    auto r = from.trySpliceTo(to.writer().fd(),16,nullptr,SPLICE_F_NONBLOCK);
+    ASSERT_TRUE(r.wouldBlock());
+    from.writer().write("abc",3);
+    ASSERT_EQ(3,from.tryTee(to,16,SPLICE_F_NONBLOCK).value());
+    ASSERT_EQ(3,from.trySpliceTo(to.writer().fd(),16).value());
+}
+
+TEST(Result,socket)
+{
+    Socket socket(AF_INET,SOCK_DGRAM);
+    char buf[16];
+    auto r = socket.tryRecv(buf,sizeof(buf),MSG_DONTWAIT);
+    ASSERT_TRUE(r.wouldBlock());
+
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    ASSERT_TRUE(pair.tryRecv(buf,sizeof(buf),MSG_DONTWAIT).wouldBlock());
+    ASSERT_EQ(5,pair.trySend("hello",5).value());
+    ASSERT_EQ(5,pair.tryRecv(buf,sizeof(buf),MSG_DONTWAIT).value());
+}
+
+TEST(Result,memMap)
+{
+    File mem = File::memfd_create("result");
+    mem.ftruncate(4096);
+    auto ok = tryMemMapCore<char>(mem,4096);
+    ASSERT_TRUE(ok);
+    (*ok)[0] = 'm';
+    ::munmap(*ok,4096);
+
+    auto failed = tryMemMapCore<char>(mem,0);
+    ASSERT_EQ(std::errc::invalid_argument,failed.error());
+}
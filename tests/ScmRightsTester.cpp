@@ -0,0 +1,154 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "FdDispatcher.h"
+#include "Pipe.h"
+#include "Socket.h"
+#include "SocketPair.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+TEST(ScmRights,socketPair)
+{
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    Pipe pipe1;
+    Pipe pipe2;
+    std::vector<File> files;
+    files.push_back(File::dup(pipe1.writer().fd()));
+    files.push_back(File::dup(pipe2.writer().fd()));
+    ASSERT_EQ(1U,pair.sendFds(files));
+
+    std::vector<File> received = pair.recvFds();
+    ASSERT_EQ(2U,received.size());
+    ASSERT_NE(files[0].fd(),received[0].fd());
+
+    // The received fds are the same pipes
+    received[0].write("one",3);
+    received[1].write("two",3);
+    std::string buf;
+    pipe1.reader().read(buf,3);
+    ASSERT_EQ("one",buf);
+    pipe2.reader().read(buf,3);
+    ASSERT_EQ("two",buf);
+
+    // A message without descriptors is not mistaken for end of file
+    pair.writer().write("x",1);
+    EXPECT_THROW(pair.recvFds(),PosixError);
+
+    pair.writer().close();
+    ASSERT_TRUE(pair.recvFds().empty()) << "end of file";
+}
+
+TEST(ScmRights,many)
+{
+    // More than one message's worth of descriptors
+    SocketPair pair(AF_UNIX,SOCK_SEQPACKET);
+    Pipe pipe;
+    std::vector<File> files;
+    for (size_t i=0; i<SCM_MAX_FDS+10; i++)
+    {
+        files.push_back(File::dup(pipe.reader().fd()));
+    }
+    ASSERT_EQ(2U,pair.sendFds(files));
+    ASSERT_EQ(SCM_MAX_FDS,pair.recvFds().size());
+    ASSERT_EQ(10U,pair.recvFds().size());
+}
+
+TEST(ScmRights,socket)
+{
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    Socket tcp(AF_INET,SOCK_STREAM);
+    std::vector<File> files;
+    files.push_back(File::dup(tcp.fd()));
+    pair.sendFds(files);
+
+    Socket received(std::move(pair.recvFds().at(0)));
+    ASSERT_EQ(AF_INET,received.domain());
+    ASSERT_EQ(SOCK_STREAM,received.type());
+    ASSERT_EQ(IPPROTO_TCP,received.protocol());
+}
+
+TEST(ScmRights,rainyDay)
+{
+    SocketPair pair(AF_UNIX,SOCK_STREAM);
+    Pipe pipe;
+    std::vector<File> files;
+    for (unsigned i=0; i<3; i++)
+    {
+        files.push_back(File::dup(pipe.reader().fd()));
+    }
+    pair.sendFds(files);
+    EXPECT_THROW(pair.recvFds(1),PosixError);
+
+    EXPECT_THROW(Socket(std::move(files[0])),PosixError) << "not a socket";
+}
+
+TEST(FdDispatcher,workers)
+{
+    const unsigned workers = 2;
+    FdDispatcher dispatcher(workers);
+    std::vector<pid_t> pids;
+    for (unsigned w=0; w<workers; w++)
+    {
+        pid_t pid = ::fork();
+        ASSERT_NE(-1,pid);
+        if (pid == 0)
+        {
+            // Write the worker number into every pipe handed over
+            File channel = dispatcher.workerSide(w);
+            while (true)
+            {
+                auto files = FdDispatcher::receive(channel);
+                if (files.empty())
+                {
+                    _exit(0);
+                }
+                for (auto& file : files)
+                {
+                    char c = '0'+w;
+                    file.write(&c,1);
+                }
+            }
+        }
+        pids.push_back(pid);
+    }
+    dispatcher.acceptorSide();
+
+    Pipe pipe;
+    for (unsigned i=0; i<4; i++)
+    {
+        ASSERT_EQ(i%workers,dispatcher.dispatch(pipe.writer()));
+    }
+    std::string got;
+    while (got.size() < 4)
+    {
+        std::string buf;
+        pipe.reader().read(buf,4-got.size());
+        got += buf;
+    }
+    std::sort(got.begin(),got.end());
+    ASSERT_EQ("0011",got);
+
+    dispatcher.shutdown();
+    for (auto pid : pids)
+    {
+        int status;
+        ASSERT_EQ(pid,::waitpid(pid,&status,0));
+        ASSERT_TRUE(WIFEXITED(status) and WEXITSTATUS(status)==0);
+    }
+}
+
+TEST(FdDispatcher,rainyDay)
+{
+    EXPECT_THROW(FdDispatcher(0),PosixError);
+
+    // A worker's dispatcher has no channels left to send on
+    FdDispatcher dispatcher(2);
+    File channel = dispatcher.workerSide(1);
+    Pipe pipe;
+    EXPECT_THROW(dispatcher.dispatch(pipe.writer()),PosixError);
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include "SharedFile.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class SharedFileTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "shared.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(SharedFileTester,copy)
+{
+    SharedFile file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    ASSERT_TRUE(file);
+    ASSERT_EQ(O_RDWR,file->mode());
+    {
+        SharedFile copy = file;
+        ASSERT_EQ(file.fd(),copy.fd()) << "no dup";
+        ASSERT_EQ(2,file.use_count());
+        copy->write("abc",3);
+    }
+    ASSERT_EQ(1,file.use_count());
+    ASSERT_TRUE(file->fdValid()) << "still open";
+    ASSERT_EQ(3U,file->getSize(false));
+
+    SharedFile moved = std::move(file);
+    ASSERT_FALSE(file);
+    ASSERT_EQ(-1,file.fd());
+    ASSERT_EQ(1,moved.use_count());
+}
+
+TEST_F(SharedFileTester,vector)
+{
+    std::vector<SharedFile> files;
+    files.emplace_back(File(m_filename,O_RDWR|O_CREAT));
+    int fd = files[0].fd();
+    for (unsigned i=0; i<100; i++)
+    {
+        files.push_back(files[0]);
+    }
+    for (auto& file : files)
+    {
+        ASSERT_EQ(fd,file.fd());
+    }
+    ASSERT_EQ(101,files[0].use_count());
+}
+
+TEST_F(SharedFileTester,fileMove)
+{
+    // File moves keep the cached mode and stat
+    File file(m_filename,O_WRONLY|O_CREAT);
+    auto ino = file.fstat().st_ino;
+    std::vector<File> files;
+    files.push_back(std::move(file));
+    for (unsigned i=0; i<10; i++)
+    {
+        files.emplace_back(); // forces reallocation and moves
+    }
+    ASSERT_EQ(O_WRONLY,files[0].mode());
+    ASSERT_EQ(ino,files[0].fstat().st_ino);
+
+    // Copy assignment gets its own fd
+    File copy;
+    copy = files[0];
+    ASSERT_NE(files[0].fd(),copy.fd());
+    ASSERT_EQ(O_WRONLY,copy.mode());
+}
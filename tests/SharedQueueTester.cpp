@@ -0,0 +1,146 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "SharedQueue.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+struct Message
+{
+    uint32_t producer;
+    uint32_t seq;
+};
+
+TEST(SpscQueue,basic)
+{
+    File shm = File::memfd_create("spsc");
+    SpscQueue<uint64_t> queue(shm,5);
+    ASSERT_EQ(8U,queue.capacity()) << "rounded up to a power of two";
+    ASSERT_EQ(SpscQueue<uint64_t>::bytesFor(8),shm.getSize(false));
+    ASSERT_TRUE(queue.empty());
+
+    uint64_t value;
+    ASSERT_FALSE(queue.pop(value));
+    for (uint64_t i=0; i<8; i++)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_FALSE(queue.push(8)) << "full";
+    ASSERT_EQ(8U,queue.size());
+
+    // A second mapping of the same file sees the same queue
+    SpscQueue<uint64_t> attached(shm);
+    ASSERT_EQ(8U,attached.capacity());
+    for (uint64_t i=0; i<8; i++)
+    {
+        ASSERT_TRUE(attached.pop(value));
+        ASSERT_EQ(i,value);
+    }
+    ASSERT_FALSE(attached.pop(value));
+    ASSERT_FALSE(attached.popWait(value,10)) << "times out";
+}
+
+TEST(SpscQueue,fork)
+{
+    File shm = File::memfd_create("spsc");
+    SpscQueue<uint64_t> queue(shm,64);
+    const uint64_t count = 100000;
+
+    pid_t pid = ::fork();
+    ASSERT_NE(-1,pid);
+    if (pid == 0)
+    {
+        for (uint64_t i=0; i<count; i++)
+        {
+            while (not queue.push(i))
+            {
+                sched_yield();
+            }
+        }
+        _exit(0);
+    }
+    uint64_t value;
+    for (uint64_t i=0; i<count; i++)
+    {
+        ASSERT_TRUE(queue.popWait(value,5000));
+        ASSERT_EQ(i,value);
+    }
+    int status;
+    ASSERT_EQ(pid,::waitpid(pid,&status,0));
+    ASSERT_TRUE(WIFEXITED(status) and WEXITSTATUS(status)==0);
+}
+
+TEST(MpscQueue,threads)
+{
+    File shm = File::memfd_create("mpsc");
+    MpscQueue<Message> queue(shm,128);
+    const unsigned producers = 4;
+    const uint32_t count = 20000;
+
+    std::vector<std::thread> threads;
+    for (unsigned p=0; p<producers; p++)
+    {
+        threads.emplace_back([&queue,p]() {
+            for (uint32_t i=0; i<count; i++)
+            {
+                while (not queue.push(Message{p,i}))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Each producer's messages arrive in order
+    std::vector<uint32_t> next(producers,0);
+    Message msg;
+    for (uint32_t i=0; i<producers*count; i++)
+    {
+        ASSERT_TRUE(queue.popWait(msg,5000));
+        ASSERT_LT(msg.producer,producers);
+        ASSERT_EQ(next[msg.producer],msg.seq);
+        next[msg.producer]++;
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_FALSE(queue.pop(msg));
+}
+
+TEST(SharedQueue,wakerTimeout)
+{
+    // Wakes that bring no element must not restart the timeout
+    QueueWaker waker;
+    std::atomic<bool> done{false};
+    std::thread waking([&]() {
+        for (unsigned i=0; i<40 and not done; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            waker.wake();
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    bool popped = waker.wait([]() {return false;},0,200);
+    auto elapsed = std::chrono::steady_clock::now()-start;
+    done = true;
+    waking.join();
+    ASSERT_FALSE(popped);
+    ASSERT_GE(elapsed,std::chrono::milliseconds(200));
+    ASSERT_LT(elapsed,std::chrono::milliseconds(500));
+}
+
+TEST(SharedQueue,rainyDay)
+{
+    File shm = File::memfd_create("bad");
+    EXPECT_THROW(SpscQueue<uint64_t> queue(shm),PosixError) << "empty file";
+    {
+        SpscQueue<uint64_t> queue(shm,16);
+    }
+    EXPECT_THROW(MpscQueue<uint64_t> queue(shm),PosixError) << "different slot size";
+}
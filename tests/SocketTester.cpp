@@ -1,4 +1,9 @@
 #include "Socket.h"
+#include "Pipe.h"
+#include "ZeroCopySender.h"
+#include "Loopback.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
 #include <string>
 #include <gtest/gtest.h>
 #include <netdb.h>
@@ -362,3 +367,149 @@ TEST_F(ClientSocketTester,badconn)
     ASSERT_THROW(client.connect(),PosixError);
 }
 
+
+// A connected TCP pair over loopback that does not need socat
+class LoopbackTester : public ::testing::Test
+{
+public:
+    Loopback m_loopback;
+    ClientSocket<AF_INET,SOCK_STREAM>* m_client = m_loopback.client.get();
+    File& m_server = m_loopback.server;
+    std::string m_filename = "loopback.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(LoopbackTester,sendFile)
+{
+    std::string msg = "0123456789abcdef";
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.write(msg);
+
+    ASSERT_EQ(10,m_client->sendFile(file,4,10));
+    ASSERT_EQ(msg.size(),(unsigned)file.lseek(0,SEEK_CUR)) << "explicit offset must not move the file offset";
+    std::string readback;
+    m_server.read(readback,10);
+    ASSERT_EQ(msg.substr(4,10),readback);
+
+    // Short at end of file
+    ASSERT_EQ(2,m_client->sendFile(file,14,100));
+    m_server.read(readback,2);
+    ASSERT_EQ("ef",readback);
+
+    // offset -1 uses the file offset
+    file.lseek(8);
+    ASSERT_EQ(8,m_client->sendFile(file,-1,100));
+    m_server.read(readback,8);
+    ASSERT_EQ("89abcdef",readback);
+}
+
+TEST_F(LoopbackTester,sendFileSplice)
+{
+    // sendfile(2) cannot read from a pipe, this goes through the splice fallback
+    std::string msg = "Hello World";
+    Pipe pipe;
+    pipe.writer().write(msg);
+    ASSERT_EQ(ssize_t(msg.size()),m_client->sendFile(pipe.reader(),-1,msg.size()));
+    std::string readback;
+    m_server.read(readback,msg.size());
+    ASSERT_EQ(msg,readback);
+}
+
+TEST_F(LoopbackTester,sendFileNonblocking)
+{
+    // Fill the socket buffers - a nonblocking send stops short instead of blocking
+    size_t size = 64<<20;
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC);
+    file.ftruncate(size);
+    ::fcntl(m_client->fd(),F_SETFL,O_NONBLOCK);
+    ssize_t n = m_client->sendFile(file,0,size);
+    ASSERT_GT(n,0);
+    ASSERT_LT(size_t(n),size);
+
+    // Full socket and end of file are told apart
+    ASSERT_EQ(-1,m_client->sendFile(file,n,size-n)) << "would block";
+    ASSERT_EQ(0,m_client->sendFile(file,size,100)) << "end of file";
+}
+
+TEST(Socket,batch)
+{
+    Socket sender(AF_INET,SOCK_DGRAM);
+    Socket receiver(AF_INET,SOCK_DGRAM);
+    sockaddr_in senderAddr = bindLoopback(sender);
+    sockaddr_in receiverAddr = bindLoopback(receiver);
+
+    DatagramBatch out(4,64);
+    ASSERT_EQ(4U,out.capacity());
+    ASSERT_EQ(64U,out.slotSize());
+    for (unsigned i=0; i<3; i++)
+    {
+        std::string msg = "message " + std::to_string(i);
+        memcpy(out.data(i),&msg[0],msg.size());
+        out.setSize(i,msg.size());
+        out.setAddr(i,(sockaddr*)&receiverAddr,sizeof(receiverAddr));
+    }
+    EXPECT_THROW(out.setSize(0,65),PosixError);
+    EXPECT_THROW(sender.sendBatch(out,5),PosixError);
+    ASSERT_EQ(3,sender.sendBatch(out,3));
+    ASSERT_EQ(9U,out.size(0));
+
+    DatagramBatch in(8,64);
+    ASSERT_EQ(3,receiver.recvBatch(in,0,MSG_WAITFORONE));
+    for (unsigned i=0; i<3; i++)
+    {
+        std::string msg = "message " + std::to_string(i);
+        ASSERT_EQ(msg.size(),in.size(i));
+        ASSERT_EQ(msg,std::string(in.data(i),in.size(i)));
+        ASSERT_FALSE(in.truncated(i));
+        ASSERT_EQ(sizeof(sockaddr_in),in.addrLen(i));
+        auto from = reinterpret_cast<const sockaddr_in*>(in.addr(i));
+        ASSERT_EQ(senderAddr.sin_port,from->sin_port);
+    }
+
+    // Oversized datagram is truncated to the slot
+    DatagramBatch small(1,4);
+    sender.sendto(out.data(0),out.size(0),0,(sockaddr*)&receiverAddr,sizeof(receiverAddr));
+    ASSERT_EQ(1,receiver.recvBatch(small));
+    ASSERT_TRUE(small.truncated(0));
+    ASSERT_EQ(4U,small.size(0));
+
+    // Nothing left to read
+    EXPECT_THROW(receiver.recvBatch(in,0,MSG_DONTWAIT),PosixError);
+}
+
+TEST_F(LoopbackTester,zeroCopy)
+{
+    ZeroCopySender sender(*m_client,1024);
+    ASSERT_EQ(1,m_client->getsockopt(SOL_SOCKET,SO_ZEROCOPY));
+
+    // Small messages are copied and released right away
+    bool smallReleased = false;
+    ASSERT_EQ(5,sender.send("small",5,[&]() {smallReleased = true;}));
+    ASSERT_TRUE(smallReleased);
+    ASSERT_EQ(0U,sender.pending());
+
+    std::vector<char> buf(64*1024,'z');
+    unsigned released = 0;
+    for (unsigned i=0; i<4; i++)
+    {
+        ASSERT_EQ(ssize_t(buf.size()),sender.send(&buf[0],buf.size(),[&]() {released++;}));
+    }
+
+    // Drain the receiver so the sends complete
+    std::vector<char> rbuf(buf.size());
+    size_t got = 0;
+    while (got < 5+4*buf.size())
+    {
+        got += m_server.read(&rbuf[0],rbuf.size());
+    }
+    sender.waitAll();
+    ASSERT_EQ(4U,released);
+    ASSERT_EQ(0U,sender.pending());
+    ASSERT_EQ(4U,sender.completed());
+    ASSERT_LE(sender.copied(),sender.completed());
+    ASSERT_EQ(0U,sender.reap());
+}
@@ -0,0 +1,79 @@
+#include <string>
+#include <vector>
+#include "StreamingWriter.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class StreamingWriterTester : public ::testing::Test
+{
+public:
+    std::string m_filename = "streaming.dat";
+
+    void TearDown()
+    {
+        File(m_filename,O_RDONLY|O_CREAT).remove();
+    }
+};
+
+TEST_F(StreamingWriterTester,basic)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    StreamingWriter::Options options;
+    options.chunkSize = 64*1024;
+    options.preallocate = 256*1024;
+    StreamingWriter writer(file,options);
+
+    std::vector<char> block(10000);
+    for (int i=0; i<100; i++)
+    {
+        std::fill(block.begin(),block.end(),char('a'+i%26));
+        writer.write(block);
+        // Never more than two chunks behind
+        ASSERT_LE(writer.pending(),off_t(3*options.chunkSize));
+    }
+    ASSERT_EQ(1000000,writer.written());
+    writer.finish();
+    ASSERT_EQ(0,writer.pending());
+
+    // The preallocation is past the end and does not show in the size
+    ASSERT_EQ(1000000U,file.getSize(false));
+    std::vector<char> readback(10000);
+    ASSERT_EQ(10000,file.pread(readback,990000));
+    ASSERT_EQ('a'+99%26,readback[0]);
+    ASSERT_EQ('a'+99%26,readback[9999]);
+    ASSERT_EQ(10000,file.pread(readback,0));
+    ASSERT_EQ('a',readback[0]);
+}
+
+TEST_F(StreamingWriterTester,trimPreallocation)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    StreamingWriter writer(file);
+    writer.write(std::string(1000,'t'));
+    ASSERT_GE(file.fstat(true).st_blocks*512,1000);
+    writer.finish();
+    // Without the trim the default 64M preallocation stays allocated past the end
+    ASSERT_EQ(1000U,file.getSize(false));
+    ASSERT_LE(file.fstat(true).st_blocks*512,64*1024);
+}
+
+TEST_F(StreamingWriterTester,append)
+{
+    File file(m_filename,O_RDWR|O_CREAT|O_TRUNC,0644);
+    file.write(std::string("head"));
+    {
+        StreamingWriter writer(file);
+        writer.write(std::string("tail"));
+        ASSERT_EQ(4,writer.written());
+        writer.finish();
+    }
+    std::string readback(8,'\0');
+    ASSERT_EQ(8,file.pread(readback,0));
+    ASSERT_EQ("headtail",readback);
+
+    StreamingWriter::Options options;
+    options.chunkSize = 0;
+    EXPECT_THROW(StreamingWriter(file,options),PosixError);
+}
@@ -0,0 +1,191 @@
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WriteAheadLog.h"
+#include "PosixError.h"
+#include <gtest/gtest.h>
+
+using namespace posixcpp;
+
+class WriteAheadLogTester : public ::testing::Test
+{
+public:
+    std::string m_dir = "wal.d";
+
+    void SetUp()
+    {
+        ::system(("rm -rf "+m_dir).c_str());
+    }
+
+    void TearDown()
+    {
+        ::system(("rm -rf "+m_dir).c_str());
+    }
+
+    std::vector<std::string> replay(const WriteAheadLog::Options& options, uint64_t& firstLsn)
+    {
+        std::vector<std::string> records;
+        firstLsn = 0;
+        WriteAheadLog wal(m_dir,options,[&](uint64_t lsn, std::string_view record) {
+            if (firstLsn == 0)
+            {
+                firstLsn = lsn;
+            }
+            EXPECT_EQ(firstLsn+records.size(),lsn);
+            records.emplace_back(record);
+        });
+        return records;
+    }
+};
+
+TEST_F(WriteAheadLogTester,crc32c)
+{
+    ASSERT_EQ(0xe3069283U,WriteAheadLog::crc32c("123456789",9));
+    ASSERT_EQ(0U,WriteAheadLog::crc32c("",0));
+    // Incremental matches one shot
+    uint32_t crc = WriteAheadLog::crc32c("1234",4);
+    ASSERT_EQ(0xe3069283U,WriteAheadLog::crc32c("56789",5,crc));
+}
+
+TEST_F(WriteAheadLogTester,basic)
+{
+    WriteAheadLog::Options options;
+    options.segmentSize = 1<<20;
+    {
+        WriteAheadLog wal(m_dir,options);
+        ASSERT_EQ(0U,wal.lastLsn());
+        ASSERT_EQ(1U,wal.append("one"));
+        ASSERT_EQ(2U,wal.append(""));
+        ASSERT_EQ(0U,wal.durableLsn());
+        ASSERT_EQ(3U,wal.commit("three"));
+        ASSERT_EQ(3U,wal.durableLsn());
+        ASSERT_EQ(1U,wal.syncs());
+        wal.sync(2);
+        ASSERT_EQ(1U,wal.syncs());
+    }
+    uint64_t first;
+    auto records = replay(options,first);
+    ASSERT_EQ((std::vector<std::string>{"one","","three"}),records);
+    ASSERT_EQ(1U,first);
+
+    // Appends continue after the replayed records
+    {
+        WriteAheadLog wal(m_dir,options);
+        ASSERT_EQ(3U,wal.lastLsn());
+        ASSERT_EQ(4U,wal.commit("four"));
+    }
+    ASSERT_EQ(4U,replay(options,first).size());
+}
+
+TEST_F(WriteAheadLogTester,rotation)
+{
+    WriteAheadLog::Options options;
+    options.segmentSize = 4096;
+    std::string record(1000,'r');
+    {
+        WriteAheadLog wal(m_dir,options);
+        for (int i=0; i<20; i++)
+        {
+            record[0] = char('a'+i);
+            wal.append(record);
+        }
+        wal.sync(wal.lastLsn());
+        ASSERT_GE(wal.segments(),5U);
+        EXPECT_THROW(wal.append(std::string(wal.maxRecordSize()+1,'x')),PosixError);
+        wal.commit(std::string(wal.maxRecordSize(),'x'));
+
+        // Checkpointed up to 10, segments holding only 1..10 go
+        size_t before = wal.segments();
+        wal.releaseUpTo(10);
+        ASSERT_LT(wal.segments(),before);
+    }
+    uint64_t first;
+    auto records = replay(options,first);
+    ASSERT_GT(first,1U);
+    ASSERT_LE(first,11U);
+    ASSERT_EQ(22U-first,records.size());
+    ASSERT_EQ('a'+int(first)-1,records[0][0]);
+    ASSERT_EQ(std::string(3,'x'),records.back().substr(0,3));
+}
+
+TEST_F(WriteAheadLogTester,tornTail)
+{
+    WriteAheadLog::Options options;
+    options.segmentSize = 1<<16;
+    {
+        WriteAheadLog wal(m_dir,options);
+        wal.append("first");
+        wal.append("second");
+        wal.commit("third");
+    }
+    // Flip a byte in the last record's data
+    {
+        File segment(m_dir+"/0000000000000001.wal",O_RDWR);
+        std::string data(1<<16,'\0');
+        segment.pread(data,0);
+        size_t pos = data.find("third");
+        ASSERT_NE(std::string::npos,pos);
+        segment.pwrite("T",1,pos);
+    }
+    uint64_t first;
+    ASSERT_EQ((std::vector<std::string>{"first","second"}),replay(options,first));
+
+    // The torn record's LSN is reused, nothing stale follows the new record
+    {
+        WriteAheadLog wal(m_dir,options);
+        ASSERT_EQ(3U,wal.commit("3"));
+    }
+    ASSERT_EQ((std::vector<std::string>{"first","second","3"}),replay(options,first));
+}
+
+TEST_F(WriteAheadLogTester,tornNextSegment)
+{
+    WriteAheadLog::Options options;
+    options.segmentSize = 4096;
+    {
+        WriteAheadLog wal(m_dir,options);
+        wal.append("one");
+        wal.append("two");
+        wal.commit("three");
+        EXPECT_THROW(wal.sync(5),PosixError);
+    }
+    // What a crash while creating the next segment leaves behind
+    File(m_dir+"/0000000000000004.wal",O_WRONLY|O_CREAT,0644);
+    uint64_t first;
+    ASSERT_EQ((std::vector<std::string>{"one","two","three"}),replay(options,first));
+    ASSERT_EQ((std::vector<std::string>{"one","two","three"}),replay(options,first));
+    {
+        WriteAheadLog wal(m_dir,options);
+        ASSERT_EQ(3U,wal.lastLsn());
+        ASSERT_EQ(1U,wal.segments());
+        ASSERT_EQ(4U,wal.commit("four"));
+    }
+    ASSERT_EQ(4U,replay(options,first).size());
+}
+
+TEST_F(WriteAheadLogTester,groupCommit)
+{
+    WriteAheadLog wal(m_dir);
+    const int threads = 8;
+    const int commits = 50;
+    std::vector<std::thread> workers;
+    for (int t=0; t<threads; t++)
+    {
+        workers.emplace_back([&wal,t]() {
+            for (int i=0; i<commits; i++)
+            {
+                uint64_t lsn = wal.commit("thread "+std::to_string(t));
+                EXPECT_GE(wal.durableLsn(),lsn);
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    ASSERT_EQ(uint64_t(threads*commits),wal.lastLsn());
+    ASSERT_EQ(wal.lastLsn(),wal.durableLsn());
+    ASSERT_LE(wal.syncs(),uint64_t(threads*commits));
+    EXPECT_THROW(WriteAheadLog(m_dir,WriteAheadLog::Options{16}),PosixError);
+}